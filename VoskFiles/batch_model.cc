@@ -13,11 +13,17 @@
 // limitations under the License.
 
 #include "batch_model.h"
+#include "batch_recognizer.h"
+#include "decoder/decodable-matrix.h"
+#include "lat/determinize-lattice-pruned.h"
 
 #include <sys/stat.h>
 
 using namespace fst;
 using namespace kaldi::nnet3;
+
+#if HAVE_CUDA
+
 using CorrelationID = CudaOnlinePipelineDynamicBatcher::CorrelationID;
 
 BatchModel::BatchModel(const char *model_path) : model_path_str_(model_path) {
@@ -109,6 +115,7 @@ BatchModel::BatchModel(const char *model_path) : model_path_str_(model_path) {
     dynamic_batcher_ = new CudaOnlinePipelineDynamicBatcher(dynamic_batcher_config,
                                                             *cuda_pipeline_);
 
+    sample_frequency_ = feature_info_.mfcc_opts.frame_opts.samp_freq;
     samples_per_chunk_ = cuda_pipeline_->GetNSampsPerChunk();
     last_id_ = 0;
 }
@@ -133,3 +140,395 @@ void BatchModel::WaitForCompletion()
 {
     dynamic_batcher_->WaitForCompletion();
 }
+
+#else // HAVE_CUDA
+
+// Online i-vectors are passed to the nnet every kIvectorPeriod frames
+static const int32 kIvectorPeriod = 10;
+// Nnet chunks per piece of a stream, about 10 seconds of audio
+static const int32 kChunksPerPiece = 20;
+// Output frames decoded between endpoint checks, 0.3 seconds
+static const int32 kEndpointCheckFrames = 10;
+
+BatchModel::BatchModel(const char *model_path) : model_path_str_(model_path) {
+
+    model_ = new Model(model_path);
+
+    trans_model_ = model_->trans_model_;
+    word_syms_ = model_->word_syms_;
+    winfo_ = model_->winfo_;
+
+    if (model_->hclg_fst_) {
+        decode_fst_ = model_->hclg_fst_;
+    } else if (model_->hcl_fst_ && model_->g_fst_) {
+        // The lazy lookahead composition caches states without locking, it
+        // can't be shared by the decoder threads. Expand it once instead
+        KALDI_LOG << "Expanding HCLr and Gr for batch decoding";
+        fst::LookaheadFst<fst::StdArc, int32> *lazy = fst::LookaheadComposeFst(*model_->hcl_fst_, *model_->g_fst_, model_->disambig_);
+        expanded_fst_ = new fst::StdConstFst(*lazy);
+        delete lazy;
+        decode_fst_ = expanded_fst_;
+    } else {
+        model_->Unref();
+        KALDI_ERR << "Can't create decoding graph";
+    }
+
+    const LatticeIncrementalDecoderConfig &online_config = model_->nnet3_decoding_config_;
+    decoder_config_.beam = online_config.beam;
+    decoder_config_.max_active = online_config.max_active;
+    decoder_config_.min_active = online_config.min_active;
+    decoder_config_.lattice_beam = online_config.lattice_beam;
+    decoder_config_.prune_interval = online_config.prune_interval;
+    decoder_config_.beam_delta = online_config.beam_delta;
+    decoder_config_.hash_ratio = online_config.hash_ratio;
+    decoder_config_.prune_scale = online_config.prune_scale;
+
+    nnet3::ComputeSimpleNnetContext(model_->nnet_->GetNnet(), &nnet_left_context_,
+                                    &nnet_right_context_);
+
+    computer_opts_.acoustic_scale = model_->decodable_opts_.acoustic_scale;
+    computer_opts_.frame_subsampling_factor = model_->decodable_opts_.frame_subsampling_factor;
+    computer_opts_.extra_left_context_initial = model_->decodable_opts_.extra_left_context_initial;
+    computer_opts_.frames_per_chunk = std::max(51, (nnet_right_context_ + 3 - nnet_right_context_ % 3));
+
+    if (model_->feature_info_.feature_type == "fbank") {
+        sample_frequency_ = model_->feature_info_.fbank_opts.frame_opts.samp_freq;
+    } else {
+        sample_frequency_ = model_->feature_info_.mfcc_opts.frame_opts.samp_freq;
+    }
+
+    // One decoder thread per core. Decoder threads mostly wait for their nnet
+    // output while it is computed, so two of them share each compute group
+    int32 num_threads = std::max(1u, std::thread::hardware_concurrency());
+    int32 num_groups = std::max(1, num_threads / 2);
+
+    for (int32 i = 0; i < num_groups; i++) {
+        ComputeGroup *group = new ComputeGroup();
+        group->computer = new NnetBatchComputer(computer_opts_, model_->nnet_->GetNnet(), model_->nnet_->Priors());
+        groups_.emplace_back(group);
+    }
+    for (auto &group : groups_) {
+        group->thread = std::thread(&BatchModel::ComputeLoop, this, group.get());
+    }
+    for (int32 i = 0; i < num_threads; i++) {
+        decoder_threads_.emplace_back(&BatchModel::DecodeLoop, this, groups_[i % num_groups].get());
+    }
+
+    KALDI_LOG << "CPU batch decoding with " << num_threads << " decoder threads and "
+              << num_groups << " nnet compute threads";
+
+    samples_per_chunk_ = computer_opts_.frames_per_chunk * model_->feature_info_.FrameShiftInSeconds() * sample_frequency_;
+    samples_per_piece_ = samples_per_chunk_ * kChunksPerPiece;
+    last_id_ = 0;
+}
+
+uint64_t BatchModel::GetID(BatchRecognizer *recognizer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t id = last_id_++;
+    recognizers_[id] = recognizer;
+    return id;
+}
+
+void BatchModel::Unregister(uint64_t id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    recognizers_.erase(id);
+
+    // A stream that is still decoding is dropped by its decoder thread
+    auto it = streams_.find(id);
+    if (it != streams_.end()) {
+        if (it->second->busy) {
+            it->second->released = true;
+        } else {
+            FreeDecoding(it->second.get());
+            streams_.erase(it);
+        }
+    }
+}
+
+BatchModel::~BatchModel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    streams_cv_.notify_all();
+    for (auto &thread : decoder_threads_) {
+        thread.join();
+    }
+
+    for (auto &group : groups_) {
+        {
+            std::lock_guard<std::mutex> lock(group->mutex);
+        }
+        group->cv.notify_all();
+        group->thread.join();
+        delete group->computer;
+    }
+
+    for (auto &stream : streams_) {
+        FreeDecoding(stream.second.get());
+    }
+
+    delete expanded_fst_;
+    model_->Unref();
+}
+
+void BatchModel::WaitForCompletion()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return in_flight_ == 0; });
+}
+
+void BatchModel::Submit(uint64_t id, std::vector<BaseFloat> *wave, bool last)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::unique_ptr<StreamState> &state = streams_[id];
+        if (!state) {
+            state.reset(new StreamState());
+        }
+        state->pieces.emplace_back();
+        state->pieces.back().wave.swap(*wave);
+        state->pieces.back().last = last;
+        in_flight_++;
+
+        if (state->busy) {
+            // The decoder thread of the previous piece queues the stream again
+            return;
+        }
+        state->busy = true;
+        ready_.push_back(id);
+    }
+    streams_cv_.notify_one();
+}
+
+void BatchModel::ComputeLoop(ComputeGroup *group)
+{
+    std::unique_lock<std::mutex> lock(group->mutex);
+    while (true) {
+        // Wait for full minibatches while decoder threads are still adding
+        // tasks, flush partial ones once they all wait for their output
+        bool allow_partial_minibatch = group->num_submitting == 0;
+        lock.unlock();
+        bool computed = group->computer->Compute(allow_partial_minibatch);
+        lock.lock();
+
+        if (!computed) {
+            {
+                std::lock_guard<std::mutex> stop_lock(mutex_);
+                if (stop_ && in_flight_ == 0)
+                    break;
+            }
+            group->cv.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+}
+
+void BatchModel::DecodeLoop(ComputeGroup *group)
+{
+    while (true) {
+        uint64_t id;
+        StreamState *state;
+        Piece piece;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            streams_cv_.wait(lock, [this] { return stop_ || !ready_.empty(); });
+            if (ready_.empty())
+                return;
+            id = ready_.front();
+            ready_.pop_front();
+            // The state stays in the map while busy, no other thread touches it
+            state = streams_[id].get();
+            piece.wave.swap(state->pieces.front().wave);
+            piece.last = state->pieces.front().last;
+            state->pieces.pop_front();
+        }
+
+        DecodePiece(group, id, state, piece);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = recognizers_.find(id);
+        if (it != recognizers_.end()) {
+            it->second->PieceDecoded(piece.wave.size());
+        }
+        if (!state->pieces.empty()) {
+            ready_.push_back(id);
+            streams_cv_.notify_one();
+        } else if (state->released || piece.last) {
+            FreeDecoding(state);
+            streams_.erase(id);
+        } else {
+            state->busy = false;
+        }
+        in_flight_--;
+        done_cv_.notify_all();
+    }
+}
+
+void BatchModel::DecodePiece(ComputeGroup *group, uint64_t id, StreamState *state, const Piece &piece)
+{
+    if (!state->pipeline) {
+        state->pipeline = new OnlineNnet2FeaturePipeline(model_->feature_info_);
+        state->decoder = new LatticeFasterOnlineDecoder(*decode_fst_, decoder_config_);
+        state->decoder->InitDecoding();
+    }
+
+    SubVector<BaseFloat> wave(piece.wave.data(), piece.wave.size());
+    state->pipeline->AcceptWaveform(sample_frequency_, wave);
+    if (piece.last) {
+        state->pipeline->InputFinished();
+    }
+
+    Matrix<BaseFloat> loglikes;
+    ComputeLoglikes(group, state, piece.last, &loglikes);
+    if (loglikes.NumRows() > 0) {
+        int32 num_rows = state->loglikes.NumRows();
+        state->loglikes.Resize(num_rows + loglikes.NumRows(), loglikes.NumCols(), kCopyData);
+        state->loglikes.RowRange(num_rows, loglikes.NumRows()).CopyFromMat(loglikes);
+    }
+
+    // Search the new frames, an endpoint ends the utterance and the rest of
+    // the output starts the next one
+    BaseFloat frame_shift = model_->feature_info_.FrameShiftInSeconds() * computer_opts_.frame_subsampling_factor;
+    while (state->decoder->NumFramesDecoded() < state->loglikes.NumRows()) {
+        DecodableMatrixScaledMapped decodable(*trans_model_, state->loglikes, 1.0);
+        state->decoder->AdvanceDecoding(&decodable, kEndpointCheckFrames);
+        if (EndpointDetected(model_->endpoint_config_, *trans_model_, frame_shift, *state->decoder)) {
+            FinishUtterance(id, state);
+        }
+    }
+
+    // The stream is complete. More pieces for the same recognizer start a new one
+    if (piece.last) {
+        if (state->decoder->NumFramesDecoded() > 0 || !state->delivered) {
+            FinishUtterance(id, state);
+        }
+        FreeDecoding(state);
+    }
+}
+
+// The nnet output for the input frames that have enough right context, or for
+// all of them at the end of the stream. The nnet has no state between chunks,
+// so the features before the first new frame are passed again as left context
+// and the output of the context frames is dropped
+void BatchModel::ComputeLoglikes(ComputeGroup *group, StreamState *state, bool last, Matrix<BaseFloat> *loglikes)
+{
+    int32 subsampling = computer_opts_.frame_subsampling_factor;
+    OnlineFeatureInterface *input = state->pipeline->InputFeature();
+    int32 num_frames = input->NumFramesReady();
+
+    int32 output_begin = state->frames_computed / subsampling;
+    int32 output_end = last ? (num_frames + subsampling - 1) / subsampling
+                            : (num_frames - nnet_right_context_ + subsampling - 1) / subsampling;
+    if (output_end <= output_begin)
+        return;
+
+    int32 left_context = (nnet_left_context_ + subsampling - 1) / subsampling * subsampling;
+    int32 begin = std::max(0, state->frames_computed - left_context);
+    int32 end = std::min(num_frames, (output_end - 1) * subsampling + nnet_right_context_ + 1);
+
+    Matrix<BaseFloat> feats(end - begin, input->Dim(), kUndefined);
+    for (int32 t = begin; t < end; t++) {
+        SubVector<BaseFloat> row(feats, t - begin);
+        input->GetFrame(t, &row);
+    }
+
+    Matrix<BaseFloat> ivectors;
+    OnlineFeatureInterface *ivector = state->pipeline->IvectorFeature();
+    if (ivector) {
+        int32 num_ivectors = (end - begin + kIvectorPeriod - 1) / kIvectorPeriod;
+        ivectors.Resize(num_ivectors, ivector->Dim(), kUndefined);
+        for (int32 i = 0; i < num_ivectors; i++) {
+            SubVector<BaseFloat> row(ivectors, i);
+            ivector->GetFrame(std::min(begin + i * kIvectorPeriod, num_frames - 1), &row);
+        }
+    }
+
+    std::vector<NnetInferenceTask> tasks;
+    group->computer->SplitUtteranceIntoTasks(true, feats, nullptr,
+                                             ivectors.NumRows() ? &ivectors : nullptr,
+                                             kIvectorPeriod, &tasks);
+
+    {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->num_submitting++;
+    }
+    for (size_t i = 0; i < tasks.size(); i++)
+        group->computer->AcceptTask(&tasks[i]);
+    {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        group->num_submitting--;
+    }
+    group->cv.notify_one();
+
+    for (size_t i = 0; i < tasks.size(); i++)
+        tasks[i].semaphore.Wait();
+
+    // The computer already subtracted the priors and applied the acoustic scale
+    Matrix<BaseFloat> output;
+    MergeTaskOutput(tasks, &output);
+    *loglikes = output.RowRange(output_begin - begin / subsampling, output_end - output_begin);
+    state->frames_computed = output_end * subsampling;
+}
+
+// Delivers the result of the decoded frames as one utterance and starts the
+// next utterance with the nnet output that was not decoded yet
+void BatchModel::FinishUtterance(uint64_t id, StreamState *state)
+{
+    LatticeFasterOnlineDecoder *decoder = state->decoder;
+    int32 num_decoded = decoder->NumFramesDecoded();
+    BaseFloat offset = state->utterance_start * model_->feature_info_.FrameShiftInSeconds() *
+                       computer_opts_.frame_subsampling_factor;
+
+    CompactLattice clat;
+    bool decoded = false;
+    if (num_decoded > 0) {
+        decoder->FinalizeDecoding();
+        Lattice lat;
+        decoder->GetRawLattice(&lat, true);
+        fst::Connect(&lat);
+        if (lat.NumStates() == 0) {
+            KALDI_WARN << "Empty lattice for stream " << id;
+        } else {
+            decoded = DeterminizeLatticePhonePrunedWrapper(*trans_model_, &lat,
+                                                           decoder_config_.lattice_beam,
+                                                           &clat, decoder_config_.det_opts);
+        }
+    }
+    Deliver(id, decoded ? &clat : nullptr, offset);
+    state->delivered = true;
+
+    int32 remaining = state->loglikes.NumRows() - num_decoded;
+    if (remaining > 0) {
+        Matrix<BaseFloat> rest(state->loglikes.RowRange(num_decoded, remaining));
+        state->loglikes.Swap(&rest);
+    } else {
+        state->loglikes.Resize(0, 0);
+    }
+    state->utterance_start += num_decoded;
+    decoder->InitDecoding();
+}
+
+void BatchModel::FreeDecoding(StreamState *state)
+{
+    delete state->decoder;
+    delete state->pipeline;
+    state->decoder = nullptr;
+    state->pipeline = nullptr;
+    state->frames_computed = 0;
+    state->utterance_start = 0;
+    state->loglikes.Resize(0, 0);
+    state->delivered = false;
+}
+
+void BatchModel::Deliver(uint64_t id, CompactLattice *clat, BaseFloat offset)
+{
+    // Results are pushed under the lock, so a recognizer being released
+    // waits in Unregister() until its result is delivered
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = recognizers_.find(id);
+    if (it != recognizers_.end()) {
+        it->second->PushResult(clat, offset);
+    }
+}
+
+#endif // HAVE_CUDA
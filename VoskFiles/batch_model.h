@@ -28,15 +28,31 @@
 #include "nnet3/nnet-am-decodable-simple.h"
 #include "nnet3/nnet-utils.h"
 
+#if HAVE_CUDA
 #include "cudadecoder/cuda-online-pipeline-dynamic-batcher.h"
 #include "cudadecoder/batched-threaded-nnet3-cuda-online-pipeline.h"
 #include "cudadecoder/batched-threaded-nnet3-cuda-pipeline2.h"
 #include "cudadecoder/cuda-pipeline-common.h"
+#else
+#include "nnet3/nnet-batch-compute.h"
+#include "decoder/lattice-faster-online-decoder.h"
+#include "online2/online-endpoint.h"
+#include "online2/online-nnet2-feature-pipeline.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#endif
 
 #include "model.h"
 
 using namespace kaldi;
+#if HAVE_CUDA
 using namespace kaldi::cuda_decoder;
+#endif
 
 class BatchRecognizer;
 
@@ -53,6 +69,7 @@ class BatchModel {
 
         std::string model_path_str_;
 
+#if HAVE_CUDA
         OnlineNnet2FeaturePipelineInfo feature_info_;
         kaldi::TransitionModel *trans_model_ = nullptr;
         kaldi::nnet3::AmNnetSimple *nnet_ = nullptr;
@@ -63,7 +80,79 @@ class BatchModel {
 
         BatchedThreadedNnet3CudaOnlinePipeline *cuda_pipeline_ = nullptr;
         CudaOnlinePipelineDynamicBatcher *dynamic_batcher_ = nullptr;
+#else
+        // CPU backend. Recognizers submit the audio of a stream in pieces of
+        // about samples_per_piece_ samples. A decoder thread takes the next
+        // piece of a stream that is not being decoded, so the pieces of one
+        // stream are decoded in order while different streams run in parallel.
+        // The nnet3 computation of the streams sharing a compute group is done
+        // in minibatches that stack chunks of all of them. Streams are split
+        // into utterances on endpoints, one result per utterance
+        struct Piece {
+            std::vector<BaseFloat> wave;
+            bool last; // FinishStream() was called after this piece
+        };
+
+        struct StreamState {
+            std::deque<Piece> pieces;
+            bool busy = false;     // queued for or taken by a decoder thread
+            bool released = false; // the recognizer is gone, drop the state once idle
+
+            // Decoding state, built for the first piece of the stream
+            OnlineNnet2FeaturePipeline *pipeline = nullptr;
+            LatticeFasterOnlineDecoder *decoder = nullptr;
+            int32 frames_computed = 0;    // input frames with nnet output, a multiple of the subsampling factor
+            int32 utterance_start = 0;    // first output frame of the current utterance
+            Matrix<BaseFloat> loglikes;   // nnet output of the current utterance
+            bool delivered = false;       // a result was delivered for this stream
+        };
+
+        struct ComputeGroup {
+            kaldi::nnet3::NnetBatchComputer *computer = nullptr;
+            std::mutex mutex;
+            std::condition_variable cv;
+            int num_submitting = 0; // decoder threads still adding tasks
+            std::thread thread;
+        };
+
+        void Submit(uint64_t id, std::vector<BaseFloat> *wave, bool last);
+        void Unregister(uint64_t id);
+        void ComputeLoop(ComputeGroup *group);
+        void DecodeLoop(ComputeGroup *group);
+        void DecodePiece(ComputeGroup *group, uint64_t id, StreamState *state, const Piece &piece);
+        void ComputeLoglikes(ComputeGroup *group, StreamState *state, bool last, Matrix<BaseFloat> *loglikes);
+        void FinishUtterance(uint64_t id, StreamState *state);
+        void FreeDecoding(StreamState *state);
+        void Deliver(uint64_t id, CompactLattice *clat, BaseFloat offset);
+
+        Model *model_ = nullptr;
+        const kaldi::TransitionModel *trans_model_ = nullptr;
+        const fst::SymbolTable *word_syms_ = nullptr;
+        const kaldi::WordBoundaryInfo *winfo_ = nullptr;
+
+        const fst::Fst<fst::StdArc> *decode_fst_ = nullptr;
+        fst::Fst<fst::StdArc> *expanded_fst_ = nullptr; // HCLr o Gr expanded for lookahead models
+        kaldi::LatticeFasterDecoderConfig decoder_config_;
+        kaldi::nnet3::NnetBatchComputerOptions computer_opts_;
+        int32 nnet_left_context_ = 0;
+        int32 nnet_right_context_ = 0;
+        int32 samples_per_piece_ = 0;
+
+        std::vector<std::unique_ptr<ComputeGroup> > groups_;
+        std::vector<std::thread> decoder_threads_;
+
+        // Streams with pieces waiting for a decoder thread, recognizers receiving results
+        std::mutex mutex_;
+        std::condition_variable streams_cv_;
+        std::condition_variable done_cv_;
+        std::unordered_map<uint64_t, std::unique_ptr<StreamState> > streams_;
+        std::deque<uint64_t> ready_;
+        std::unordered_map<uint64_t, BatchRecognizer *> recognizers_;
+        int64 in_flight_ = 0; // pieces submitted and not decoded yet
+        bool stop_ = false;
+#endif
 
+        float sample_frequency_; // of the model features, the recognizers resample to it
         int32 samples_per_chunk_;
         uint64_t last_id_;
 };
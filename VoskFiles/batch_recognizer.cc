@@ -21,23 +21,24 @@
 BatchRecognizer::BatchRecognizer(BatchModel *model, float
                                  sample_frequency) : model_(model), sample_frequency_(sample_frequency),
                                  initialized_(false), callbacks_set_(false), nlsml_(false) {
+#if !HAVE_CUDA
+    pending_samples_ = 0;
+#endif
     id_ = model->GetID(this);
 
 
     resampler_ = new LinearResample(
-        sample_frequency, 16000.0f,
-        std::min(sample_frequency / 2, 16000.0f / 2), 6);
+        sample_frequency, model->sample_frequency_,
+        std::min(sample_frequency / 2, model->sample_frequency_ / 2), 6);
 }
 
 BatchRecognizer::~BatchRecognizer() {
-    delete resampler_;
+#if HAVE_CUDA
     // Drop the ID
-}
-
-void BatchRecognizer::FinishStream()
-{
-    SubVector<BaseFloat> chunk = buffer_.Range(0, buffer_.Dim());
-    model_->dynamic_batcher_->Push(id_, !initialized_, true, chunk);
+#else
+    model_->Unregister(id_);
+#endif
+    delete resampler_;
 }
 
 void BatchRecognizer::PushLattice(CompactLattice &clat, BaseFloat offset)
@@ -45,7 +46,14 @@ void BatchRecognizer::PushLattice(CompactLattice &clat, BaseFloat offset)
     fst::ScaleLattice(fst::GraphLatticeScale(0.9), &clat);
 
     CompactLattice aligned_lat;
-    WordAlignLattice(clat, *model_->trans_model_, *model_->winfo_, 0, &aligned_lat);
+    if (model_->winfo_) {
+        WordAlignLattice(clat, *model_->trans_model_, *model_->winfo_, 0, &aligned_lat);
+    } else {
+        aligned_lat = clat;
+        fst::RmEpsilon(&aligned_lat, true);
+        fst::CreateSuperFinal(&aligned_lat);
+        TopSortCompactLatticeIfNeeded(&aligned_lat);
+    }
 
     MinimumBayesRisk mbr(aligned_lat);
     const vector<BaseFloat> &conf = mbr.GetOneBestConfidences();
@@ -77,6 +85,7 @@ void BatchRecognizer::PushLattice(CompactLattice &clat, BaseFloat offset)
         ss << "</interpretation>\n";
         ss << "</result>\n";
 
+        std::lock_guard<std::mutex> lock(results_mutex_);
         results_.push(ss.str());
 
     } else {
@@ -102,6 +111,7 @@ void BatchRecognizer::PushLattice(CompactLattice &clat, BaseFloat offset)
 
 //      KALDI_LOG << "Result " << id << " " << obj.dump();
 
+        std::lock_guard<std::mutex> lock(results_mutex_);
         results_.push(obj.dump());
     }
 }
@@ -112,6 +122,13 @@ void BatchRecognizer::SetNLSML(bool nlsml)
 }
 
 
+#if HAVE_CUDA
+void BatchRecognizer::FinishStream()
+{
+    SubVector<BaseFloat> chunk = buffer_.Range(0, buffer_.Dim());
+    model_->dynamic_batcher_->Push(id_, !initialized_, true, chunk);
+}
+
 void BatchRecognizer::AcceptWaveform(const char *data, int len)
 {
     uint64_t id = id_;
@@ -180,8 +197,75 @@ void BatchRecognizer::AcceptWaveform(const char *data, int len)
     }
 }
 
+int BatchRecognizer::GetNumPendingChunks()
+{
+    return model_->dynamic_batcher_->GetNumPendingChunks(id_);
+}
+
+#else // HAVE_CUDA
+
+// The CPU backend decodes the audio in pieces of a few seconds, here it is
+// only resampled and buffered until a piece is full
+void BatchRecognizer::AcceptWaveform(const char *data, int len)
+{
+    Vector<BaseFloat> input_wave(len / 2);
+    for (int i = 0; i < len / 2; i++)
+        input_wave(i) = *(((short *)data) + i);
+
+    Vector<BaseFloat> resampled_wave;
+    resampler_->Resample(input_wave, true, &resampled_wave);
+
+    stream_.insert(stream_.end(), resampled_wave.Data(), resampled_wave.Data() + resampled_wave.Dim());
+    pending_samples_ += resampled_wave.Dim();
+
+    if (stream_.size() >= static_cast<size_t>(model_->samples_per_piece_)) {
+        model_->Submit(id_, &stream_, false);
+        stream_.clear();
+    }
+}
+
+void BatchRecognizer::FinishStream()
+{
+    model_->Submit(id_, &stream_, true);
+    stream_.clear();
+}
+
+void BatchRecognizer::PushResult(CompactLattice *clat, BaseFloat offset)
+{
+    if (clat) {
+        PushLattice(*clat, offset);
+    } else {
+        std::lock_guard<std::mutex> lock(results_mutex_);
+        if (nlsml_) {
+            results_.push("<?xml version=\"1.0\"?>\n"
+                          "<result grammar=\"default\">\n"
+                          "<interpretation confidence=\"1.0\">\n"
+                          "<instance/>\n"
+                          "<input><noinput/></input>\n"
+                          "</interpretation>\n"
+                          "</result>\n");
+        } else {
+            results_.push("{\"text\": \"\"}");
+        }
+    }
+}
+
+void BatchRecognizer::PieceDecoded(int64 num_samples)
+{
+    pending_samples_ -= num_samples;
+}
+
+int BatchRecognizer::GetNumPendingChunks()
+{
+    int64 pending = pending_samples_;
+    return static_cast<int>((pending + model_->samples_per_chunk_ - 1) / model_->samples_per_chunk_);
+}
+
+#endif // HAVE_CUDA
+
 const char* BatchRecognizer::FrontResult()
 {
+    std::lock_guard<std::mutex> lock(results_mutex_);
     if (results_.empty()) {
         return "";
     }
@@ -190,13 +274,9 @@ const char* BatchRecognizer::FrontResult()
 
 void BatchRecognizer::Pop()
 {
+    std::lock_guard<std::mutex> lock(results_mutex_);
     if (results_.empty()) {
         return;
     }
     results_.pop();
 }
-
-int BatchRecognizer::GetNumPendingChunks()
-{
-    return model_->dynamic_batcher_->GetNumPendingChunks(id_);
-}
@@ -19,6 +19,8 @@
 #include "util/common-utils.h"
 #include "feat/resample.h"
 
+#include <atomic>
+#include <mutex>
 #include <queue>
 
 #include "batch_model.h"
@@ -38,8 +40,11 @@ class BatchRecognizer {
         void SetNLSML(bool nlsml);
 
     private:
+        friend class BatchModel;
 
         void PushLattice(CompactLattice &clat, BaseFloat offset);
+        void PushResult(CompactLattice *clat, BaseFloat offset);
+        void PieceDecoded(int64 num_samples);
 
         BatchModel *model_;
         uint64_t id_;
@@ -47,9 +52,15 @@ class BatchRecognizer {
         bool callbacks_set_;
         bool nlsml_;
         float sample_frequency_;
+        std::mutex results_mutex_; // results are pushed from the decoding threads
         std::queue<std::string> results_;
         LinearResample *resampler_;
+#if HAVE_CUDA
         kaldi::Vector<BaseFloat> buffer_;
+#else
+        std::vector<BaseFloat> stream_; // resampled audio not submitted to the model yet
+        std::atomic<int64> pending_samples_;
+#endif
 };
 
 #endif /* VOSK_BATCH_RECOGNIZER_H */
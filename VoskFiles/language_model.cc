@@ -18,35 +18,110 @@
 // A modified version from chain/language-model.cc for static backoff
 
 #include <algorithm>
-#include <numeric>
 
 #include "language_model.h"
 
 using namespace kaldi;
 
+// Initial size of the hash tables, must be a power of two.
+static const size_t kInitialTableSize = 1024;
+
+bool LanguageModelEstimator::History::operator == (const History &other) const {
+  if (length != other.length)
+    return false;
+  for (int32 i = 0; i < length; i++)
+    if (words[i] != other.words[i])
+      return false;
+  return true;
+}
+
+size_t LanguageModelEstimator::History::Hash() const {
+  uint64 hash = 14695981039346656037ULL + length;
+  for (int32 i = 0; i < length; i++)
+    hash = (hash ^ static_cast<uint32>(words[i])) * 1099511628211ULL;
+  return hash ^ (hash >> 29);
+}
+
+LanguageModelEstimator::History LanguageModelEstimator::History::Backoff() const {
+  History ans;
+  ans.length = length - 1;
+  std::copy(words + 1, words + length, ans.words);
+  return ans;
+}
+
+static inline size_t HashCount(int32 lm_state, int32 phone) {
+  uint64 hash = (static_cast<uint64>(lm_state) << 32) | static_cast<uint32>(phone);
+  hash *= 11400714819323198485ULL;
+  return hash ^ (hash >> 29);
+}
+
 void LanguageModelEstimator::AddCounts(const std::vector<int32> &sentence) {
   KALDI_ASSERT(opts_.ngram_order >= 2 && "--ngram-order must be >= 2");
   int32 order = opts_.ngram_order;
   // 0 is used for left-context at the beginning of the file.. treat it as BOS.
-  std::vector<int32> history(0);
+  History history;
   std::vector<int32>::const_iterator iter = sentence.begin(),
       end = sentence.end();
   for (; iter != end; ++iter) {
     KALDI_ASSERT(*iter != 0);
     IncrementCount(history, *iter);
-    history.push_back(*iter);
-    if (history.size() >= order)
-      history.erase(history.begin());
+    // keep the last order - 1 words.
+    if (history.length == order - 1) {
+      std::copy(history.words + 1, history.words + history.length, history.words);
+      history.words[history.length - 1] = *iter;
+    } else {
+      history.words[history.length++] = *iter;
+    }
   }
   // Probability of end of sentence.  This will end up getting ignored later, but
   // it still makes a difference for probability-normalization reasons.
   IncrementCount(history, 0);
 }
 
-void LanguageModelEstimator::IncrementCount(const std::vector<int32> &history,
+void LanguageModelEstimator::IncrementCount(const History &history,
                                             int32 next_phone) {
   int32 lm_state_index = FindOrCreateLmStateIndexForHistory(history);
-  lm_states_[lm_state_index].AddCount(next_phone, 1);
+  AddCount(lm_state_index, next_phone, 1);
+}
+
+void LanguageModelEstimator::AddCount(int32 lm_state_index, int32 phone,
+                                      int32 count) {
+  if (count_table_.empty())
+    count_table_.resize(kInitialTableSize, -1);
+
+  size_t mask = count_table_.size() - 1;
+  size_t slot = HashCount(lm_state_index, phone) & mask;
+  for (; count_table_[slot] != -1; slot = (slot + 1) & mask) {
+    Count &c = counts_[count_table_[slot]];
+    if (c.lm_state == lm_state_index && c.phone == phone) {
+      c.count += count;
+      lm_states_[lm_state_index].tot_count += count;
+      return;
+    }
+  }
+
+  LmState &lm_state = lm_states_[lm_state_index];
+  Count c;
+  c.lm_state = lm_state_index;
+  c.phone = phone;
+  c.count = count;
+  c.next = lm_state.first_count;
+  lm_state.first_count = counts_.size();
+  lm_state.tot_count += count;
+  count_table_[slot] = counts_.size();
+  counts_.push_back(c);
+
+  if (counts_.size() * 2 > count_table_.size()) {
+    std::vector<int32> table(count_table_.size() * 2, -1);
+    mask = table.size() - 1;
+    for (size_t i = 0; i < counts_.size(); i++) {
+      slot = HashCount(counts_[i].lm_state, counts_[i].phone) & mask;
+      while (table[slot] != -1)
+        slot = (slot + 1) & mask;
+      table[slot] = i;
+    }
+    count_table_.swap(table);
+  }
 }
 
 void LanguageModelEstimator::SetParentCounts() {
@@ -54,31 +129,40 @@ void LanguageModelEstimator::SetParentCounts() {
   for (int32 l = 0; l < num_lm_states; l++) {
     int32 l_iter = lm_states_[l].backoff_lmstate_index;
     while (l_iter != -1) {
-      lm_states_[l_iter].Add(lm_states_[l]);
+      // Add the contents of state l.  Appending to counts_ doesn't change
+      // the chain of l, which is not an ancestor of itself.
+      for (int32 c = lm_states_[l].first_count; c != -1; c = counts_[c].next) {
+        int32 phone = counts_[c].phone, count = counts_[c].count;
+        AddCount(l_iter, phone, count);
+      }
       l_iter = lm_states_[l_iter].backoff_lmstate_index;
     }
   }
 }
 
 int32 LanguageModelEstimator::FindLmStateIndexForHistory(
-    const std::vector<int32> &hist) const {
-  MapType::const_iterator iter = hist_to_lmstate_index_.find(hist);
-  if (iter == hist_to_lmstate_index_.end())
+    const History &hist) const {
+  if (lmstate_table_.empty())
     return -1;
-  else
-    return iter->second;
+  size_t mask = lmstate_table_.size() - 1;
+  for (size_t slot = hist.Hash() & mask; lmstate_table_[slot] != -1;
+       slot = (slot + 1) & mask) {
+    if (lm_states_[lmstate_table_[slot]].history == hist)
+      return lmstate_table_[slot];
+  }
+  return -1;
 }
 
 int32 LanguageModelEstimator::FindNonzeroLmStateIndexForHistory(
-    std::vector<int32> hist) const {
+    History hist) const {
   while (1) {
     int32 l = FindLmStateIndexForHistory(hist);
     if (l == -1 || lm_states_[l].tot_count == 0) {
       // no such state or state has zero count.
-      if (hist.empty())
+      if (hist.length == 0)
         KALDI_ERR << "Error looking up LM state index for history "
                   << "(likely code bug)";
-      hist.erase(hist.begin());  // back off.
+      hist = hist.Backoff();  // back off.
     } else {
       return l;
     }
@@ -86,44 +170,41 @@ int32 LanguageModelEstimator::FindNonzeroLmStateIndexForHistory(
 }
 
 int32 LanguageModelEstimator::FindOrCreateLmStateIndexForHistory(
-    const std::vector<int32> &hist) {
-  MapType::const_iterator iter = hist_to_lmstate_index_.find(hist);
-  if (iter != hist_to_lmstate_index_.end())
-    return iter->second;
+    const History &hist) {
+  int32 existing = FindLmStateIndexForHistory(hist);
+  if (existing != -1)
+    return existing;
+
+  if (lmstate_table_.size() < (lm_states_.size() + 1) * 2) {
+    std::vector<int32> table(std::max(kInitialTableSize, lmstate_table_.size() * 2), -1);
+    size_t mask = table.size() - 1;
+    for (size_t i = 0; i < lm_states_.size(); i++) {
+      size_t slot = lm_states_[i].history.Hash() & mask;
+      while (table[slot] != -1)
+        slot = (slot + 1) & mask;
+      table[slot] = i;
+    }
+    lmstate_table_.swap(table);
+  }
+
   int32 ans = lm_states_.size();  // index of next element
-  // next statement relies on default construct of LmState.
-  lm_states_.resize(lm_states_.size() + 1);
+  lm_states_.push_back(LmState());
   lm_states_.back().history = hist;
-  hist_to_lmstate_index_[hist] = ans;
+  size_t mask = lmstate_table_.size() - 1;
+  size_t slot = hist.Hash() & mask;
+  while (lmstate_table_[slot] != -1)
+    slot = (slot + 1) & mask;
+  lmstate_table_[slot] = ans;
 
   // make sure backoff_lmstate_index is set
-  if (hist.size() > 0) {
-    std::vector<int32> backoff_hist(hist.begin() + 1,
-                                    hist.end());
-    int32 backoff_lm_state = FindOrCreateLmStateIndexForHistory(backoff_hist);
+  if (hist.length > 0) {
+    int32 backoff_lm_state = FindOrCreateLmStateIndexForHistory(hist.Backoff());
     lm_states_[ans].backoff_lmstate_index = backoff_lm_state;
   }
   num_active_lm_states_++;
   return ans;
 }
 
-void LanguageModelEstimator::LmState::AddCount(int32 phone, int32 count) {
-  std::map<int32, int32>::iterator iter = phone_to_count.find(phone);
-  if (iter == phone_to_count.end())
-    phone_to_count[phone] = count;
-  else
-    iter->second += count;
-  tot_count += count;
-}
-
-void LanguageModelEstimator::LmState::Add(const LmState &other) {
-  KALDI_ASSERT(&other != this);
-  std::map<int32, int32>::const_iterator iter = other.phone_to_count.begin(),
-      end = other.phone_to_count.end();
-  for (; iter != end; ++iter)
-    AddCount(iter->first, iter->second);
-}
-
 int32 LanguageModelEstimator::AssignFstStates() {
   int32 num_lm_states = lm_states_.size();
   int32 current_fst_state = 0;
@@ -146,7 +227,7 @@ void LanguageModelEstimator::Estimate(fst::StdVectorFst *fst) {
 }
 
 int32 LanguageModelEstimator::FindInitialFstState() const {
-  std::vector<int32> history(0);
+  History history;
   int32 l = FindNonzeroLmStateIndexForHistory(history);
   KALDI_ASSERT(l != -1 && lm_states_[l].fst_state != -1);
   return lm_states_[l].fst_state;
@@ -157,12 +238,15 @@ void LanguageModelEstimator::OutputToFst(
     fst::StdVectorFst *fst) const {
   KALDI_ASSERT(num_states == num_active_lm_states_);
   fst->DeleteStates();
+  fst->ReserveStates(num_states);
   for (int32 i = 0; i < num_states; i++)
     fst->AddState();
   fst->SetStart(FindInitialFstState());
 
-  int64 tot_count = 0;
-  double tot_logprob = 0.0;
+  // (phone, count) of the current state, sorted by phone so that the arcs
+  // come out sorted and no ArcSort() is needed.  The backoff arc has label 0
+  // and goes first.
+  std::vector<std::pair<int32, int32> > phone_counts;
 
   int32 num_lm_states = lm_states_.size();
   // note: not all lm-states end up being 'active'.
@@ -173,19 +257,25 @@ void LanguageModelEstimator::OutputToFst(
     }
     int32 state_count = lm_state.tot_count;
     KALDI_ASSERT(state_count != 0);
-    std::map<int32, int32>::const_iterator
-        iter = lm_state.phone_to_count.begin(),
-        end = lm_state.phone_to_count.end();
-    for (; iter != end; ++iter) {
-      int32 phone = iter->first, count = iter->second;
+
+    phone_counts.clear();
+    for (int32 c = lm_state.first_count; c != -1; c = counts_[c].next)
+      phone_counts.push_back(std::make_pair(counts_[c].phone, counts_[c].count));
+    std::sort(phone_counts.begin(), phone_counts.end());
+
+    fst->ReserveArcs(lm_state.fst_state, phone_counts.size() + 1);
+    if (lm_state.backoff_lmstate_index >= 0) {
+      fst->AddArc(lm_state.fst_state, fst::StdArc(0, 0, fst::TropicalWeight(-log(1 - opts_.discount)), lm_states_[lm_state.backoff_lmstate_index].fst_state));
+    }
+
+    for (size_t i = 0; i < phone_counts.size(); i++) {
+      int32 phone = phone_counts[i].first, count = phone_counts[i].second;
       BaseFloat logprob = log(count * opts_.discount / state_count);
-      tot_count += count;
-      tot_logprob += logprob * count;
       if (phone == 0) {  // Go to final state
         fst->SetFinal(lm_state.fst_state, fst::TropicalWeight(-logprob));
       } else {  // It becomes a transition.
-        std::vector<int32> next_history(lm_state.history);
-        next_history.push_back(phone);
+        History next_history(lm_state.history);
+        next_history.words[next_history.length++] = phone;
         int32 dest_lm_state = FindNonzeroLmStateIndexForHistory(next_history),
             dest_fst_state = lm_states_[dest_lm_state].fst_state;
         KALDI_ASSERT(dest_fst_state != -1);
@@ -194,16 +284,8 @@ void LanguageModelEstimator::OutputToFst(
                                 dest_fst_state));
       }
     }
-    if (lm_state.backoff_lmstate_index >= 0) {
-      fst->AddArc(lm_state.fst_state, fst::StdArc(0, 0, fst::TropicalWeight(-log(1 - opts_.discount)), lm_states_[lm_state.backoff_lmstate_index].fst_state));
-    }
   }
-  fst::Connect(fst);
-  // Make sure that Connect does not delete any states.
-  int32 num_states_connected = fst->NumStates();
-  KALDI_ASSERT(num_states_connected == num_states);
-  // arc-sort.  ilabel or olabel doesn't matter, it's an acceptor.
-  fst::ArcSort(fst, fst::ILabelCompare<fst::StdArc>());
+  // Every state is reachable by construction, no Connect() is needed.
   KALDI_LOG << "Created language model with " << num_states
             << " states and " << fst::NumArcs(*fst) << " arcs.";
 }
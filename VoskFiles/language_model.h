@@ -20,7 +20,6 @@
 #define VOSK_LANGUAGE_MODEL_H
 
 #include <vector>
-#include <map>
 
 #include "base/kaldi-common.h"
 #include "util/common-utils.h"
@@ -52,6 +51,7 @@ class LanguageModelEstimator {
   LanguageModelEstimator(LanguageModelOptions &opts): opts_(opts),
                                                       num_active_lm_states_(0) {
     KALDI_ASSERT(opts.ngram_order >= 1);
+    KALDI_ASSERT(opts.ngram_order <= kMaxNgramOrder);
   }
 
   // Adds counts for this sentence.  Basically does: for each n-gram in the
@@ -63,13 +63,26 @@ class LanguageModelEstimator {
   // no concept here of backoff arcs.
   void Estimate(fst::StdVectorFst *fst);
 
+  static const int32 kMaxNgramOrder = 8;
+
  protected:
+  // A history of up to kMaxNgramOrder words, stored inline so that LM states
+  // and hash lookups need no allocation.  Only the first 'length' words are
+  // meaningful.
+  struct History {
+    int32 length;
+    int32 words[kMaxNgramOrder];
+
+    History(): length(0) { }
+    bool operator == (const History &other) const;
+    size_t Hash() const;
+    // the history with the oldest word removed.
+    History Backoff() const;
+  };
+
   struct LmState {
     // the phone history associated with this state (length can vary).
-    std::vector<int32> history;
-
-    // maps from
-    std::map<int32, int32> phone_to_count;
+    History history;
 
     // total count of this state.  As we back off states to lower-order states
     // (and note that this is a hard backoff where we completely remove un-needed
@@ -84,53 +97,62 @@ class LanguageModelEstimator {
     // If not set, it's -1.
     int32 fst_state;
 
-    void AddCount(int32 phone, int32 count);
-
-    // Add the contents of another LmState.
-    void Add(const LmState &other);
+    // index in counts_ of the first count of this state, the counts of a
+    // state are chained through Count::next.  -1 if there are none.
+    int32 first_count;
 
     LmState(): tot_count(0), backoff_lmstate_index(-1),
-               fst_state(-1) { }
-    LmState(const LmState &other):
-        history(other.history), phone_to_count(other.phone_to_count),
-        tot_count(other.tot_count),
-        backoff_lmstate_index(other.backoff_lmstate_index),
-        fst_state(other.fst_state) { }
+               fst_state(-1), first_count(-1) { }
   };
 
-  // maps from history to int32
-  typedef unordered_map<std::vector<int32>, int32, VectorHasher<int32> > MapType;
+  // count of 'phone' following the history of 'lm_state'.
+  struct Count {
+    int32 lm_state;
+    int32 phone;
+    int32 count;
+    int32 next;
+  };
 
   LanguageModelOptions opts_;
 
-  MapType hist_to_lmstate_index_;
+  // LM states and counts are kept in flat arrays and referred to by index.
   std::vector<LmState> lm_states_;  // indexed by lmstate_index, the LmStates.
+  std::vector<Count> counts_;
+
+  // Open-addressing hash tables with linear probing, their size is a power
+  // of two and they are kept at most half full.  Slots hold indexes into
+  // lm_states_ and counts_ respectively, -1 for empty slots.
+  std::vector<int32> lmstate_table_;
+  std::vector<int32> count_table_;
 
   // Keeps track of the number of lm states that have nonzero counts.
   int32 num_active_lm_states_;
 
 
   // adds the counts for this ngram (called from AddCounts()).
-  inline void IncrementCount(const std::vector<int32> &history,
+  inline void IncrementCount(const History &history,
                              int32 next_phone);
 
+  // adds 'count' to the count of 'phone' in this LM state.
+  void AddCount(int32 lm_state_index, int32 phone, int32 count);
+
   // sets up tot_count_with_parents in all the lm-states
   void SetParentCounts();
 
   // Finds and returns an LM-state index for a history -- or -1 if it doesn't
   // exist.  No backoff is done.
-  int32 FindLmStateIndexForHistory(const std::vector<int32> &hist) const;
+  int32 FindLmStateIndexForHistory(const History &hist) const;
 
   // Finds and returns an LM-state index for a history -- and creates one if
   // it doesn't exist -- and also creates any backoff states needed, down
   // to history-length no_prune_ngram_order - 1.
-  int32 FindOrCreateLmStateIndexForHistory(const std::vector<int32> &hist);
+  int32 FindOrCreateLmStateIndexForHistory(const History &hist);
 
   // Finds and returns the most specific LM-state index for a history or
   // backed-off versions of it, that exists and has nonzero count.  Will die if
   // there is no such history.  [e.g. if there is no unigram backoff state,
   // which generally speaking there won't be.]
-  int32 FindNonzeroLmStateIndexForHistory(std::vector<int32> hist) const;
+  int32 FindNonzeroLmStateIndexForHistory(History hist) const;
 
   // after all backoff has been done, assigns FST state indexes to all states
   // that exist and have nonzero count.  Returns the number of states.
@@ -139,7 +161,7 @@ class LanguageModelEstimator {
   // find the FST index of the initial-state, and returns it.
   int32 FindInitialFstState() const;
 
-  // Write to an FST
+  // Write to an FST.  Arcs are emitted already sorted by label.
   void OutputToFst(
       int32 num_fst_states,
       fst::StdVectorFst *fst) const;
@@ -17,6 +17,8 @@
 // For details of possible model layout see doc/models.md section model-structure
 
 #include "model.h"
+#include "json.h"
+#include "language_model.h"
 
 #include <sys/stat.h>
 #include <fst/fst.h>
@@ -25,11 +27,21 @@
 #include <fst/extensions/ngram/ngram-fst.h>
 
 
+#include <fstream>
+
 #ifdef HAVE_MKL
 // We need to set num threads
 #include <mkl.h>
 #endif
 
+// Threads the BLAS library may use inside one matrix operation of the nnet3
+// computation. The matrices of the small models are too small to gain from
+// more than one on the Raspberry Pi, the decoding can run on its own thread
+// instead, see Recognizer::SetWorkerThread()
+#ifndef VOSK_BLAS_THREADS
+#define VOSK_BLAS_THREADS 1
+#endif
+
 namespace fst {
 
 static FstRegisterer<StdOLabelLookAheadFst> OLabelLookAheadFst_StdArc_registerer;
@@ -37,6 +49,26 @@ static FstRegisterer<NGramFst<StdArc>> NGramFst_StdArc_registerer;
 
 }  // namespace fst
 
+// Reads a decoding graph from file. FSTs in OpenFst binary format are opened
+// in memory-mapped mode, so const and compact FSTs are paged in from the file
+// on demand instead of being copied to the heap; other formats (and FST types
+// that can't be mapped) go through the regular Kaldi reader
+static fst::Fst<fst::StdArc> *ReadFstMapped(const string &filename)
+{
+    std::ifstream strm(filename, std::ios_base::in | std::ios_base::binary);
+    int32 magic = 0;
+    if (strm.read(reinterpret_cast<char *>(&magic), sizeof(magic)) &&
+        magic == fst::kFstMagicNumber) {
+        strm.seekg(0);
+        fst::FstReadOptions ropts(filename);
+        ropts.mode = fst::FstReadOptions::MAP;
+        fst::Fst<fst::StdArc> *fst = fst::Fst<fst::StdArc>::Read(strm, ropts);
+        if (fst)
+            return fst;
+    }
+    return fst::ReadFstKaldiGeneric(filename);
+}
+
 #ifdef __ANDROID__
 #include <android/log.h>
 static void KaldiLogHandler(const LogMessageEnvelope &env, const char *message)
@@ -114,7 +146,9 @@ Model::Model(const char *model_path) : model_path_str_(model_path) {
     SetLogHandler(KaldiLogHandler);
 
 #ifdef HAVE_MKL
-    mkl_set_num_threads(1);
+    mkl_set_num_threads(VOSK_BLAS_THREADS);
+#elif defined(HAVE_OPENBLAS)
+    openblas_set_num_threads(VOSK_BLAS_THREADS);
 #endif
 
     struct stat buffer;
@@ -216,6 +250,12 @@ void Model::ConfigureV2()
     rnnlm_lm_rxfilename_ = model_path_str_ + "/rnnlm/final.raw";
 }
 
+// Feature frames kept by the online feature pipeline, older ones are
+// recycled so a recognizer that is never reset doesn't grow. This must
+// cover the longest utterance, the i-vector extractor re-reads frames of
+// the current utterance when the silence weights change
+static const int32 kMaxFeatureVectors = 30000;
+
 void Model::ReadDataFiles()
 {
     struct stat buffer;
@@ -229,10 +269,14 @@ void Model::ReadDataFiles()
         feature_info_.feature_type = "mfcc";
         ReadConfigFromFile(mfcc_conf_rxfilename_, &feature_info_.mfcc_opts);
         feature_info_.mfcc_opts.frame_opts.allow_downsample = true; // It is safe to downsample
+        if (feature_info_.mfcc_opts.frame_opts.max_feature_vectors <= 0)
+            feature_info_.mfcc_opts.frame_opts.max_feature_vectors = kMaxFeatureVectors;
     } else if (stat(fbank_conf_rxfilename_.c_str(), &buffer) == 0) {
         feature_info_.feature_type = "fbank";
         ReadConfigFromFile(fbank_conf_rxfilename_, &feature_info_.fbank_opts);
         feature_info_.fbank_opts.frame_opts.allow_downsample = true; // It is safe to downsample
+        if (feature_info_.fbank_opts.frame_opts.max_feature_vectors <= 0)
+            feature_info_.fbank_opts.frame_opts.max_feature_vectors = kMaxFeatureVectors;
     } else {
         KALDI_ERR << "Failed to find feature config file";
     }
@@ -290,11 +334,11 @@ void Model::ReadDataFiles()
 
     if (stat(hclg_fst_rxfilename_.c_str(), &buffer) == 0) {
         KALDI_LOG << "Loading HCLG from " << hclg_fst_rxfilename_;
-        hclg_fst_ = fst::ReadFstKaldiGeneric(hclg_fst_rxfilename_);
+        hclg_fst_ = ReadFstMapped(hclg_fst_rxfilename_);
     } else {
         KALDI_LOG << "Loading HCL and G from " << hcl_fst_rxfilename_ << " " << g_fst_rxfilename_;
-        hcl_fst_ = fst::StdFst::Read(hcl_fst_rxfilename_);
-        g_fst_ = fst::StdFst::Read(g_fst_rxfilename_);
+        hcl_fst_ = ReadFstMapped(hcl_fst_rxfilename_);
+        g_fst_ = ReadFstMapped(g_fst_rxfilename_);
         if (!ReadIntegerVectorSimple(disambig_rxfilename_, &disambig_)) {
             KALDI_ERR << "Could not read disambig symbol table from file "
                       << disambig_rxfilename_;
@@ -323,6 +367,19 @@ void Model::ReadDataFiles()
         winfo_ = new kaldi::WordBoundaryInfo(opts, winfo_rxfilename_);
     }
 
+    // Rescoring models are the largest optional part of the model and are
+    // read on first use, see LoadRescoring()
+}
+
+void Model::LoadRescoring()
+{
+    std::call_once(rescoring_once_, [this] { ReadRescoringFiles(); });
+}
+
+void Model::ReadRescoringFiles()
+{
+    struct stat buffer;
+
     if (stat(carpa_rxfilename_.c_str(), &buffer) == 0) {
 
         KALDI_LOG << "Loading subtract G.fst model from " << std_fst_rxfilename_;
@@ -371,6 +428,151 @@ void Model::Unref()
     }
 }
 
+GrammarGraph *Model::GetGrammarGraph(const char *grammar)
+{
+    {
+        std::lock_guard<std::mutex> lock(grammar_cache_mutex_);
+        auto it = grammar_cache_.find(grammar);
+        if (it != grammar_cache_.end()) {
+            it->second->Ref();
+            return it->second;
+        }
+    }
+
+    // Compiling takes long, do it without the lock so that other recognizers
+    // can still get cached graphs meanwhile
+    GrammarGraph *graph = CompileGrammarGraph(grammar);
+    if (!graph)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(grammar_cache_mutex_);
+    auto it = grammar_cache_.find(grammar);
+    if (it != grammar_cache_.end()) {
+        // Another thread compiled the same grammar first, keep its graph
+        graph->Unref();
+        it->second->Ref();
+        return it->second;
+    }
+
+    // Evict the oldest graph when full. Recognizers and contexts using it keep
+    // their own references, so it is only freed when they drop them
+    if (grammar_cache_order_.size() >= kMaxCachedGrammars) {
+        auto oldest = grammar_cache_.find(grammar_cache_order_.front());
+        oldest->second->Unref();
+        grammar_cache_.erase(oldest);
+        grammar_cache_order_.pop_front();
+    }
+
+    // The cache keeps the initial reference
+    grammar_cache_.emplace(grammar, graph);
+    grammar_cache_order_.push_back(grammar);
+    graph->Ref();
+    return graph;
+}
+
+bool Model::AddGrammarContext(const char *name, const char *grammar)
+{
+    if (!hcl_fst_) {
+        KALDI_WARN << "Runtime graphs are not supported by this model";
+        return false;
+    }
+
+    GrammarGraph *graph = GetGrammarGraph(grammar);
+    if (!graph)
+        return false;
+
+    std::lock_guard<std::mutex> lock(grammar_cache_mutex_);
+    auto it = grammar_contexts_.find(name);
+    if (it != grammar_contexts_.end()) {
+        it->second->Unref();
+        it->second = graph;
+    } else {
+        grammar_contexts_.emplace(name, graph);
+    }
+    return true;
+}
+
+GrammarGraph *Model::GetGrammarContext(const char *name)
+{
+    std::lock_guard<std::mutex> lock(grammar_cache_mutex_);
+
+    auto it = grammar_contexts_.find(name);
+    if (it == grammar_contexts_.end())
+        return nullptr;
+
+    it->second->Ref();
+    return it->second;
+}
+
+GrammarGraph *Model::CompileGrammarGraph(const char *grammar)
+{
+    json::JSON obj;
+    obj = json::JSON::Load(grammar);
+
+    if (obj.length() <= 0) {
+        KALDI_WARN << "Expecting array of strings, got: '" << grammar << "'";
+        return nullptr;
+    }
+
+    KALDI_LOG << obj;
+
+    kaldi::Timer timer;
+    LanguageModelOptions opts;
+
+    opts.ngram_order = 2;
+    opts.discount = 0.5;
+
+    std::set<vector<int32> > sentences, prefixes;
+    LanguageModelEstimator estimator(opts);
+    for (int i = 0; i < obj.length(); i++) {
+        bool ok;
+        string line = obj[i].ToString(ok);
+        if (!ok) {
+            KALDI_ERR << "Expecting array of strings, got: '" << obj << "'";
+        }
+
+        std::vector<int32> sentence;
+        stringstream ss(line);
+        string token;
+        bool oov = false;
+        while (getline(ss, token, ' ')) {
+            if (token.empty())
+                continue;
+            int32 id = word_syms_->Find(token);
+            if (id == fst::kNoSymbol) {
+                KALDI_WARN << "Ignoring sentence with word missing in vocabulary: '" << token << "'";
+                oov = true;
+            } else {
+                sentence.push_back(id);
+            }
+        }
+        // A sentence without one of its words is another sentence, and an
+        // empty one would let the grammar accept silence as a result
+        if (oov || sentence.empty())
+            continue;
+        estimator.AddCounts(sentence);
+        sentences.insert(sentence);
+        for (size_t len = 1; len < sentence.size(); len++)
+            prefixes.emplace(sentence.begin(), sentence.begin() + len);
+    }
+    fst::StdVectorFst g_fst;
+    estimator.Estimate(&g_fst);
+
+    // The lookahead composition is expanded once here. The lazy version caches
+    // states on access and could not be shared between decoders
+    fst::LookaheadFst<fst::StdArc, int32> *decode_fst = fst::LookaheadComposeFst(*hcl_fst_, g_fst, disambig_);
+    fst::StdConstFst *graph_fst = new fst::StdConstFst(*decode_fst);
+    delete decode_fst;
+
+    KALDI_LOG << "Compiled grammar graph with " << graph_fst->NumStates() << " states in "
+              << timer.Elapsed() * 1000 << " ms";
+
+    GrammarGraph *graph = new GrammarGraph(graph_fst);
+    graph->sentences_.swap(sentences);
+    graph->prefixes_.swap(prefixes);
+    return graph;
+}
+
 int Model::FindWord(const char *word)
 {
     if (!word_syms_)
@@ -380,6 +582,11 @@ int Model::FindWord(const char *word)
 }
 
 Model::~Model() {
+    for (auto &entry : grammar_contexts_)
+        entry.second->Unref();
+    for (auto &entry : grammar_cache_)
+        entry.second->Unref();
+
     delete decodable_info_;
     delete trans_model_;
     delete nnet_;
@@ -391,3 +598,24 @@ Model::~Model() {
     delete g_fst_;
     delete graph_lm_fst_;
 }
+
+GrammarGraph::GrammarGraph(fst::Fst<fst::StdArc> *fst) : fst_(fst) {
+    ref_cnt_ = 1;
+}
+
+GrammarGraph::~GrammarGraph() {
+    delete fst_;
+}
+
+void GrammarGraph::Ref()
+{
+    std::atomic_fetch_add_explicit(&ref_cnt_, 1, std::memory_order_relaxed);
+}
+
+void GrammarGraph::Unref()
+{
+    if (std::atomic_fetch_sub_explicit(&ref_cnt_, 1, std::memory_order_release) == 1) {
+         std::atomic_thread_fence(std::memory_order_acquire);
+         delete this;
+    }
+}
@@ -32,11 +32,40 @@
 #include "rnnlm/rnnlm-utils.h"
 #include "rnnlm/rnnlm-lattice-rescoring.h"
 #include <atomic>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <unordered_map>
 
 using namespace kaldi;
 using namespace std;
 
 class Recognizer;
+class Model;
+
+// Decoding graph compiled from a runtime grammar: HCL composed with the
+// grammar G and expanded to a ConstFst, so it can be shared read-only by
+// every recognizer using the same grammar
+class GrammarGraph {
+
+public:
+    void Ref();
+    void Unref();
+    const fst::Fst<fst::StdArc> &Fst() const { return *fst_; }
+    bool HasSentence(const vector<int32> &words) const { return sentences_.count(words) > 0; }
+    // True if a longer grammar sentence starts with these words
+    bool HasLongerSentence(const vector<int32> &words) const { return prefixes_.count(words) > 0; }
+
+protected:
+    friend class Model;
+    GrammarGraph(fst::Fst<fst::StdArc> *fst);
+    ~GrammarGraph();
+
+    fst::Fst<fst::StdArc> *fst_;
+    std::set<vector<int32> > sentences_; // grammar sentences as word ids
+    std::set<vector<int32> > prefixes_;  // proper prefixes of the sentences
+    std::atomic<int> ref_cnt_;
+};
 
 class Model {
 
@@ -46,13 +75,33 @@ public:
     void Unref();
     int FindWord(const char *word);
 
+    // Returns the decoding graph for a JSON grammar, with a reference the
+    // caller must Unref(), or nullptr if the grammar is invalid. Graphs are
+    // compiled once and cached for the lifetime of the model
+    GrammarGraph *GetGrammarGraph(const char *grammar);
+
+    // Registers a grammar under a name, so recognizers can switch to it with
+    // Recognizer::SetGrammarContext(). Registering a name again replaces it
+    bool AddGrammarContext(const char *name, const char *grammar);
+
+    // Returns the graph registered under the name, with a reference the
+    // caller must Unref(), or nullptr if there is none
+    GrammarGraph *GetGrammarContext(const char *name);
+
+    // Reads the const ARPA and RNNLM rescoring models on first call, so they
+    // cost neither startup time nor memory unless a recognizer rescores
+    void LoadRescoring();
+
 protected:
     ~Model();
     void ConfigureV1();
     void ConfigureV2();
     void ReadDataFiles();
+    void ReadRescoringFiles();
+    GrammarGraph *CompileGrammarGraph(const char *grammar);
 
     friend class Recognizer;
+    friend class BatchModel;
 
     string model_path_str_;
     string nnet3_rxfilename_;
@@ -99,6 +148,16 @@ protected:
     CuMatrix<BaseFloat> word_embedding_mat;
     kaldi::nnet3::Nnet rnnlm;
     bool rnnlm_enabled_ = false;
+    std::once_flag rescoring_once_;
+
+    // Compiled grammar graphs, keyed by the grammar text. Holds at most
+    // kMaxCachedGrammars graphs, the oldest one is evicted first
+    static const size_t kMaxCachedGrammars = 16;
+    std::mutex grammar_cache_mutex_;
+    std::unordered_map<string, GrammarGraph *> grammar_cache_;
+    std::deque<string> grammar_cache_order_;
+    // Named grammar contexts, each holds a reference to a cached graph
+    std::unordered_map<string, GrammarGraph *> grammar_contexts_;
 
     std::atomic<int> ref_cnt_;
 };
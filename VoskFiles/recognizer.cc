@@ -16,7 +16,11 @@
 #include "json.h"
 #include "fstext/fstext-utils.h"
 #include "lat/sausages.h"
-#include "language_model.h"
+#include <limits>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 using namespace fst;
 using namespace kaldi::nnet3;
@@ -39,7 +43,7 @@ Recognizer::Recognizer(Model *model, float sample_frequency) : model_(model), sp
     decoder_ = new kaldi::SingleUtteranceNnet3IncrementalDecoder(model_->nnet3_decoding_config_,
             *model_->trans_model_,
             *model_->decodable_info_,
-            model_->hclg_fst_ ? *model_->hclg_fst_ : *decode_fst_,
+            model_->hclg_fst_ ? *model_->hclg_fst_ : GrammarFst(),
             feature_pipeline_);
 
     InitState();
@@ -62,11 +66,12 @@ Recognizer::Recognizer(Model *model, float sample_frequency, char const *grammar
     decoder_ = new kaldi::SingleUtteranceNnet3IncrementalDecoder(model_->nnet3_decoding_config_,
             *model_->trans_model_,
             *model_->decodable_info_,
-            model_->hclg_fst_ ? *model_->hclg_fst_ : *decode_fst_,
+            model_->hclg_fst_ ? *model_->hclg_fst_ : GrammarFst(),
             feature_pipeline_);
 
+    // The rescoring models are built on the first result, so a closed grammar
+    // profile set right after creation never loads them, see SetClosedGrammar()
     InitState();
-    InitRescoring();
 }
 
 Recognizer::Recognizer(Model *model, float sample_frequency, SpkModel *spk_model) : model_(model), spk_model_(spk_model), sample_frequency_(sample_frequency) {
@@ -88,7 +93,7 @@ Recognizer::Recognizer(Model *model, float sample_frequency, SpkModel *spk_model
     decoder_ = new kaldi::SingleUtteranceNnet3IncrementalDecoder(model_->nnet3_decoding_config_,
             *model_->trans_model_,
             *model_->decodable_info_,
-            model_->hclg_fst_ ? *model_->hclg_fst_ : *decode_fst_,
+            model_->hclg_fst_ ? *model_->hclg_fst_ : GrammarFst(),
             feature_pipeline_);
 
     spk_feature_ = new OnlineMfcc(spk_model_->spkvector_mfcc_opts);
@@ -98,19 +103,19 @@ Recognizer::Recognizer(Model *model, float sample_frequency, SpkModel *spk_model
 }
 
 Recognizer::~Recognizer() {
+    StopWorker();
+
     delete decoder_;
     delete feature_pipeline_;
     delete silence_weighting_;
-    delete g_fst_;
+    if (grammar_graph_)
+        grammar_graph_->Unref();
+    if (pending_graph_)
+        pending_graph_->Unref();
     delete decode_fst_;
     delete spk_feature_;
 
-    delete lm_to_subtract_;
-    delete carpa_to_add_;
-    delete carpa_to_add_scale_;
-    delete rnnlm_info_;
-    delete rnnlm_to_add_;
-    delete rnnlm_to_add_scale_;
+    FreeRescoring();
 
     model_->Unref();
     if (spk_model_)
@@ -130,6 +135,9 @@ void Recognizer::InitState()
 
 void Recognizer::InitRescoring()
 {
+    rescoring_ready_ = true;
+    model_->LoadRescoring();
+
     if (model_->graph_lm_fst_) {
 
         fst::CacheOptions cache_opts(true, -1);
@@ -149,42 +157,117 @@ void Recognizer::InitRescoring()
     }
 }
 
+void Recognizer::FreeRescoring()
+{
+    delete lm_to_subtract_;
+    delete carpa_to_add_;
+    delete carpa_to_add_scale_;
+    delete rnnlm_info_;
+    delete rnnlm_to_add_;
+    delete rnnlm_to_add_scale_;
+
+    lm_to_subtract_ = nullptr;
+    carpa_to_add_ = nullptr;
+    carpa_to_add_scale_ = nullptr;
+    rnnlm_info_ = nullptr;
+    rnnlm_to_add_ = nullptr;
+    rnnlm_to_add_scale_ = nullptr;
+    rescoring_ready_ = false;
+}
+
 void Recognizer::CleanUp()
 {
-    delete silence_weighting_;
-    silence_weighting_ = new kaldi::OnlineSilenceWeighting(*model_->trans_model_, model_->feature_info_.silence_weighting_config, 3);
+    // OnlineSilenceWeighting has no reset, construct it again in place
+    // instead of going through the allocator for every utterance. It is
+    // gone only after FinalResult()
+    if (silence_weighting_) {
+        silence_weighting_->~OnlineSilenceWeighting();
+        new (silence_weighting_) kaldi::OnlineSilenceWeighting(*model_->trans_model_, model_->feature_info_.silence_weighting_config, 3);
+    } else {
+        silence_weighting_ = new kaldi::OnlineSilenceWeighting(*model_->trans_model_, model_->feature_info_.silence_weighting_config, 3);
+    }
 
-    if (decoder_)
+    if (rearmed_ && feature_pipeline_) {
+       // Skip the frames of the dropped utterance that are ready but were
+       // never decoded, so they don't leak into the next one. The decoder
+       // counts subsampled frames, rounded up like the nnet3 decodable does
+       frame_offset_ = (feature_pipeline_->NumFramesReady() + 2) / 3;
+    } else if (decoder_) {
        frame_offset_ += decoder_->NumFramesDecoded();
+    }
+    rearmed_ = false;
+
+    early_commit_count_ = 0;
 
     // Each 10 minutes we drop the pipeline to save frontend memory in continuous processing
     // here we drop few frames remaining in the feature pipeline but hope it will not
     // cause a huge accuracy drop since it happens not very frequently.
 
-    // Also restart if we retrieved final result already
+    // Also restart if we retrieved final result already, the feature pipeline
+    // doesn't accept input after it.
+
+    // In always-on mode the pipeline recycles old feature frames by itself
+    // (see max_feature_vectors in the model), but the i-vector extractor keeps
+    // an i-vector per period and its OnlineCmvn the cached stats of all frames.
+    // So it is still rebuilt, each 30 minutes instead of 10, and the i-vector
+    // adaptation state is carried over to the new pipeline
 
-    if (decoder_ == nullptr || state_ == RECOGNIZER_FINALIZED || frame_offset_ > 20000) {
+    bool restart = always_on_ ? frame_offset_ > 60000 : frame_offset_ > 20000;
+    if (decoder_ == nullptr || state_ == RECOGNIZER_FINALIZED || restart) {
         samples_round_start_ += samples_processed_;
         samples_processed_ = 0;
         frame_offset_ = 0;
 
+        OnlineIvectorExtractorAdaptationState *adaptation = nullptr;
+        if (always_on_ && state_ != RECOGNIZER_FINALIZED && feature_pipeline_ &&
+            feature_pipeline_->IvectorFeature() != nullptr) {
+            adaptation = new OnlineIvectorExtractorAdaptationState(model_->feature_info_.ivector_extractor_info);
+            feature_pipeline_->IvectorFeature()->GetAdaptationState(adaptation);
+        }
+
         delete decoder_;
         delete feature_pipeline_;
+        if (pending_graph_)
+            SwitchGrammarGraph();
 
         feature_pipeline_ = new kaldi::OnlineNnet2FeaturePipeline (model_->feature_info_);
+        if (adaptation) {
+            feature_pipeline_->IvectorFeature()->SetAdaptationState(*adaptation);
+            delete adaptation;
+        }
         decoder_ = new kaldi::SingleUtteranceNnet3IncrementalDecoder(model_->nnet3_decoding_config_,
             *model_->trans_model_,
             *model_->decodable_info_,
-            model_->hclg_fst_ ? *model_->hclg_fst_ : *decode_fst_,
+            model_->hclg_fst_ ? *model_->hclg_fst_ : GrammarFst(),
             feature_pipeline_);
 
         if (spk_model_) {
             delete spk_feature_;
             spk_feature_ = new OnlineMfcc(spk_model_->spkvector_mfcc_opts);
         }
+    } else if (pending_graph_) {
+        // Only the decoder is bound to the graph, the feature pipeline and
+        // its i-vector state carry over to the next utterance
+        delete decoder_;
+        SwitchGrammarGraph();
+        decoder_ = new kaldi::SingleUtteranceNnet3IncrementalDecoder(model_->nnet3_decoding_config_,
+            *model_->trans_model_,
+            *model_->decodable_info_,
+            GrammarFst(),
+            feature_pipeline_);
+        decoder_->InitDecoding(frame_offset_);
     } else {
         decoder_->InitDecoding(frame_offset_);
     }
+
+    // A new utterance starts, the worker thread resumes with the chunks held
+    // after the endpoint. Only now, once the decoder and the pipeline above
+    // are rebuilt or reset, it may touch them again
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        worker_endpoint_ = false;
+    }
+    worker_cv_.notify_one();
 }
 
 void Recognizer::UpdateSilenceWeights()
@@ -222,6 +305,8 @@ void Recognizer::SetNLSML(bool nlsml)
 
 void Recognizer::SetEndpointerMode(int mode)
 {
+    WaitWorker();
+
     float scale = 1.0;
     switch(mode) {
         case 1:
@@ -243,6 +328,8 @@ void Recognizer::SetEndpointerMode(int mode)
 
 void Recognizer::SetEndpointerDelays(float t_start_max, float t_end, float t_max)
 {
+    WaitWorker();
+
     float rule1, rule2, rule3, rule4, rule5;
 
     rule1 = t_start_max;
@@ -261,8 +348,37 @@ void Recognizer::SetEndpointerDelays(float t_start_max, float t_end, float t_max
 }
 
 
+void Recognizer::SetEarlyCommit(float min_confidence, int stable_chunks)
+{
+    WaitWorker();
+
+    KALDI_LOG << "Updating early commit " << min_confidence << "," << stable_chunks;
+    early_commit_confidence_ = min_confidence;
+    early_commit_chunks_ = stable_chunks;
+    early_commit_count_ = 0;
+}
+
+void Recognizer::SetClosedGrammar(bool closed_grammar)
+{
+    if (closed_grammar == closed_grammar_) {
+        return;
+    }
+
+    closed_grammar_ = closed_grammar;
+    if (closed_grammar_) {
+        FreeRescoring();
+    }
+}
+
+void Recognizer::SetAlwaysOn(bool always_on)
+{
+    always_on_ = always_on;
+}
+
 void Recognizer::SetSpkModel(SpkModel *spk_model)
 {
+    WaitWorker();
+
     if (state_ == RECOGNIZER_RUNNING) {
         KALDI_ERR << "Can't add speaker model to already running recognizer";
         return;
@@ -274,6 +390,8 @@ void Recognizer::SetSpkModel(SpkModel *spk_model)
 
 void Recognizer::SetGrm(char const *grammar)
 {
+    WaitWorker();
+
     if (state_ == RECOGNIZER_RUNNING) {
         KALDI_ERR << "Can't add grammar to already running recognizer";
         return;
@@ -284,9 +402,19 @@ void Recognizer::SetGrm(char const *grammar)
         return;
     }
 
+    if (pending_graph_) {
+        pending_graph_->Unref();
+        pending_graph_ = nullptr;
+    }
+
     delete decode_fst_;
+    decode_fst_ = nullptr;
 
     if (!strcmp(grammar, "[]")) {
+        if (grammar_graph_) {
+            grammar_graph_->Unref();
+            grammar_graph_ = nullptr;
+        }
         decode_fst_ = LookaheadComposeFst(*model_->hcl_fst_, *model_->g_fst_, model_->disambig_);
     } else {
         UpdateGrammarFst(grammar);
@@ -305,7 +433,7 @@ void Recognizer::SetGrm(char const *grammar)
     decoder_ = new kaldi::SingleUtteranceNnet3IncrementalDecoder(model_->nnet3_decoding_config_,
             *model_->trans_model_,
             *model_->decodable_info_,
-            *decode_fst_,
+            GrammarFst(),
             feature_pipeline_);
 
     if (spk_model_) {
@@ -316,87 +444,127 @@ void Recognizer::SetGrm(char const *grammar)
     state_ = RECOGNIZER_INITIALIZED;
 }
 
-
-void Recognizer::UpdateGrammarFst(char const *grammar)
+bool Recognizer::SetGrammarContext(char const *name)
 {
-    json::JSON obj;
-    obj = json::JSON::Load(grammar);
+    WaitWorker();
 
-    if (obj.length() <= 0) {
-        KALDI_WARN << "Expecting array of strings, got: '" << grammar << "'";
-        return;
+    if (!model_->hcl_fst_) {
+        KALDI_WARN << "Runtime graphs are not supported by this model";
+        return false;
     }
 
-    KALDI_LOG << obj;
+    GrammarGraph *graph = model_->GetGrammarContext(name);
+    if (!graph) {
+        KALDI_WARN << "Unknown grammar context: '" << name << "'";
+        return false;
+    }
 
-    LanguageModelOptions opts;
+    if (pending_graph_)
+        pending_graph_->Unref();
+    pending_graph_ = graph;
 
-    opts.ngram_order = 2;
-    opts.discount = 0.5;
+    // A running utterance keeps its graph, the switch happens in CleanUp()
+    // once it ends. Before the first chunk there is nothing to keep
+    if (state_ == RECOGNIZER_INITIALIZED) {
+        delete decoder_;
+        SwitchGrammarGraph();
+        decoder_ = new kaldi::SingleUtteranceNnet3IncrementalDecoder(model_->nnet3_decoding_config_,
+                *model_->trans_model_,
+                *model_->decodable_info_,
+                GrammarFst(),
+                feature_pipeline_);
+        decoder_->InitDecoding(frame_offset_);
+    }
+    return true;
+}
 
-    LanguageModelEstimator estimator(opts);
-    for (int i = 0; i < obj.length(); i++) {
-        bool ok;
-        string line = obj[i].ToString(ok);
-        if (!ok) {
-            KALDI_ERR << "Expecting array of strings, got: '" << obj << "'";
-        }
+// Makes the pending grammar context current. The decoder must be deleted
+// before, it references the old graph
+void Recognizer::SwitchGrammarGraph()
+{
+    if (grammar_graph_)
+        grammar_graph_->Unref();
+    grammar_graph_ = pending_graph_;
+    pending_graph_ = nullptr;
 
-        std::vector<int32> sentence;
-        stringstream ss(line);
-        string token;
-        while (getline(ss, token, ' ')) {
-            int32 id = model_->word_syms_->Find(token);
-            if (id == kNoSymbol) {
-                KALDI_WARN << "Ignoring word missing in vocabulary: '" << token << "'";
-            } else {
-                sentence.push_back(id);
-            }
-        }
-        estimator.AddCounts(sentence);
+    delete decode_fst_;
+    decode_fst_ = nullptr;
+}
+
+void Recognizer::UpdateGrammarFst(char const *grammar)
+{
+    GrammarGraph *graph = model_->GetGrammarGraph(grammar);
+    if (!graph) {
+        return;
     }
-    g_fst_ = new StdVectorFst();
-    estimator.Estimate(g_fst_);
 
-    decode_fst_ = LookaheadComposeFst(*model_->hcl_fst_, *g_fst_, model_->disambig_);
+    if (grammar_graph_)
+        grammar_graph_->Unref();
+    grammar_graph_ = graph;
+}
+
+const fst::Fst<fst::StdArc> &Recognizer::GrammarFst() const
+{
+    if (grammar_graph_)
+        return grammar_graph_->Fst();
+    return *decode_fst_;
 }
 
 
+// int16 samples to float, 8 samples per step with NEON
+static void ConvertSamples(const short *in, BaseFloat *out, int len)
+{
+    int i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 8 <= len; i += 8) {
+        int16x8_t v = vld1q_s16(in + i);
+        vst1q_f32(out + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))));
+        vst1q_f32(out + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))));
+    }
+#endif
+    for (; i < len; i++)
+        out[i] = in[i];
+}
+
 bool Recognizer::AcceptWaveform(const char *data, int len)
 {
-    Vector<BaseFloat> wave;
-    wave.Resize(len / 2, kUndefined);
-    for (int i = 0; i < len / 2; i++)
-        wave(i) = *(((short *)data) + i);
-    return AcceptWaveform(wave);
+    return AcceptWaveform((const short *)data, len / 2);
 }
 
 bool Recognizer::AcceptWaveform(const short *sdata, int len)
 {
-    Vector<BaseFloat> wave;
-    wave.Resize(len, kUndefined);
-    for (int i = 0; i < len; i++)
-        wave(i) = sdata[i];
-    return AcceptWaveform(wave);
+    // The conversion buffer only grows, so steady streaming doesn't allocate
+    if (wave_buffer_.size() < (size_t)len)
+        wave_buffer_.resize(len);
+    ConvertSamples(sdata, wave_buffer_.data(), len);
+    return AcceptWaveform(SubVector<BaseFloat>(wave_buffer_.data(), len));
 }
 
 bool Recognizer::AcceptWaveform(const float *fdata, int len)
 {
-    Vector<BaseFloat> wave;
-    wave.Resize(len, kUndefined);
-    for (int i = 0; i < len; i++)
-        wave(i) = fdata[i];
-    return AcceptWaveform(wave);
+    // Float samples are used in place, without a copy
+    return AcceptWaveform(SubVector<BaseFloat>(fdata, len));
 }
 
-bool Recognizer::AcceptWaveform(Vector<BaseFloat> &wdata)
+bool Recognizer::AcceptWaveform(const VectorBase<BaseFloat> &wdata)
 {
     // Cleanup if we finalized previous utterance or the whole feature pipeline
     if (!(state_ == RECOGNIZER_RUNNING || state_ == RECOGNIZER_INITIALIZED)) {
+        WaitWorker();
         CleanUp();
     }
     state_ = RECOGNIZER_RUNNING;
 
+    if (worker_.joinable()) {
+        return QueueChunk(wdata);
+    }
+    return DecodeChunk(wdata);
+}
+
+// Feature extraction, nnet3 computation and search for a chunk of audio, on
+// the caller thread or on the worker thread
+bool Recognizer::DecodeChunk(const VectorBase<BaseFloat> &wdata)
+{
     int step = static_cast<int>(sample_frequency_ * 0.2);
     for (int i = 0; i < wdata.Dim(); i+= step) {
         SubVector<BaseFloat> r = wdata.Range(i, std::min(step, wdata.Dim() - i));
@@ -414,9 +582,134 @@ bool Recognizer::AcceptWaveform(Vector<BaseFloat> &wdata)
         return true;
     }
 
+    if (early_commit_chunks_ > 0 && EarlyCommitDetected()) {
+        return true;
+    }
+
     return false;
 }
 
+// Maximum number of chunks waiting for the worker thread, AcceptWaveform()
+// blocks when the worker falls this far behind
+#define MAX_QUEUED_CHUNKS 8
+
+void Recognizer::SetWorkerThread(bool worker_thread)
+{
+    if (worker_thread == worker_.joinable()) {
+        return;
+    }
+
+    if (worker_thread) {
+        worker_ = std::thread(&Recognizer::WorkerLoop, this);
+    } else {
+        StopWorker();
+    }
+}
+
+// Queues a copy of the chunk for the worker thread. The endpoint returned is
+// the one of the chunks decoded so far, so it comes up to a chunk later than
+// when decoding on the caller thread. Once the worker found an endpoint it
+// stops decoding: the utterance ends there and the chunks queued after it are
+// held for the next utterance, which starts in CleanUp()
+bool Recognizer::QueueChunk(const VectorBase<BaseFloat> &wdata)
+{
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    // Held chunks are not taken by the worker, don't wait for room for them
+    caller_cv_.wait(lock, [this] { return chunks_.size() < MAX_QUEUED_CHUNKS || worker_endpoint_; });
+
+    if (worker_error_) {
+        std::exception_ptr error;
+        std::swap(error, worker_error_);
+        std::rethrow_exception(error);
+    }
+
+    std::vector<BaseFloat> chunk;
+    if (!free_chunks_.empty()) {
+        chunk.swap(free_chunks_.back());
+        free_chunks_.pop_back();
+    }
+    chunk.assign(wdata.Data(), wdata.Data() + wdata.Dim());
+    chunks_.push_back(std::move(chunk));
+    worker_cv_.notify_one();
+
+    return worker_endpoint_;
+}
+
+void Recognizer::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    while (true) {
+        worker_cv_.wait(lock, [this] { return (!chunks_.empty() && !worker_endpoint_) || worker_stop_; });
+        if (chunks_.empty() || worker_endpoint_) {
+            break;
+        }
+
+        std::vector<BaseFloat> chunk = std::move(chunks_.front());
+        chunks_.pop_front();
+        worker_busy_ = true;
+        caller_cv_.notify_all();
+        lock.unlock();
+
+        bool endpoint = false;
+        std::exception_ptr error;
+        try {
+            endpoint = DecodeChunk(SubVector<BaseFloat>(chunk.data(), chunk.size()));
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        worker_busy_ = false;
+        worker_endpoint_ = worker_endpoint_ || endpoint;
+        free_chunks_.push_back(std::move(chunk));
+        if (error) {
+            // Reported by the next AcceptWaveform(), the rest of the utterance is dropped
+            worker_error_ = error;
+            while (!chunks_.empty()) {
+                free_chunks_.push_back(std::move(chunks_.front()));
+                chunks_.pop_front();
+            }
+        }
+        caller_cv_.notify_all();
+    }
+}
+
+// Waits until the worker thread decoded every queued chunk of the utterance,
+// up to the endpoint if it found one. Everything touching the decoder or the
+// feature pipeline from the caller thread must call it first
+void Recognizer::WaitWorker()
+{
+    if (!worker_.joinable()) {
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(worker_mutex_);
+    caller_cv_.wait(lock, [this] { return (chunks_.empty() || worker_endpoint_) && !worker_busy_; });
+}
+
+void Recognizer::StopWorker()
+{
+    if (!worker_.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        worker_stop_ = true;
+    }
+    worker_cv_.notify_one();
+    worker_.join();
+    worker_stop_ = false;
+    worker_endpoint_ = false;
+
+    // Chunks held after an endpoint are dropped, the caller thread doesn't
+    // decode them
+    while (!chunks_.empty()) {
+        free_chunks_.push_back(std::move(chunks_.front()));
+        chunks_.pop_front();
+    }
+}
+
 // Computes an xvector from a chunk of speech features.
 static void RunNnetComputation(const MatrixBase<BaseFloat> &features,
     const nnet3::Nnet &nnet, nnet3::CachingOptimizingCompiler *compiler,
@@ -522,9 +815,8 @@ static void CopyLatticeForMbr(CompactLattice &lat, CompactLattice *lat_out)
     TopSortCompactLatticeIfNeeded(lat_out);
 }
 
-const char *Recognizer::MbrResult(CompactLattice &rlat)
+void Recognizer::MbrWords(CompactLattice &rlat)
 {
-
     CompactLattice aligned_lat;
     if (model_->winfo_) {
         WordAlignLattice(rlat, *model_->trans_model_, *model_->winfo_, 0, &aligned_lat);
@@ -540,27 +832,44 @@ const char *Recognizer::MbrResult(CompactLattice &rlat)
 
     int size = words.size();
 
+    result_.text.clear();
+    result_.words.resize(size);
+    for (int i = 0; i < size; i++) {
+        const string &word = model_->word_syms_->Find(words[i]);
+        if (i) {
+            result_.text += " ";
+        }
+
+        RecognizerWord &w = result_.words[i];
+        w.id = words[i];
+        w.text_start = result_.text.size();
+        w.text_length = word.size();
+        w.conf = conf[i];
+        w.start = samples_round_start_ / sample_frequency_ + (frame_offset_ + times[i].first) * 0.03;
+        w.end = samples_round_start_ / sample_frequency_ + (frame_offset_ + times[i].second) * 0.03;
+
+        result_.text += word;
+    }
+}
+
+const char *Recognizer::MbrResult(CompactLattice &rlat)
+{
+    ResultWords(rlat);
+
     json::JSON obj;
-    stringstream text;
 
     // Create JSON object
-    for (int i = 0; i < size; i++) {
-        json::JSON word;
-
-        if (words_) {
-            word["word"] = model_->word_syms_->Find(words[i]);
-            word["start"] = samples_round_start_ / sample_frequency_ + (frame_offset_ + times[i].first) * 0.03;
-            word["end"] = samples_round_start_ / sample_frequency_ + (frame_offset_ + times[i].second) * 0.03;
-            word["conf"] = conf[i];
+    if (words_) {
+        for (const RecognizerWord &w : result_.words) {
+            json::JSON word;
+            word["word"] = result_.text.substr(w.text_start, w.text_length);
+            word["start"] = w.start;
+            word["end"] = w.end;
+            word["conf"] = w.conf;
             obj["result"].append(word);
         }
-
-        if (i) {
-            text << " ";
-        }
-        text << model_->word_syms_->Find(words[i]);
     }
-    obj["text"] = text.str();
+    obj["text"] = result_.text;
 
     if (spk_model_) {
         Vector<BaseFloat> xvector;
@@ -637,6 +946,83 @@ static bool CompactLatticeToWordAlignmentWeight(const CompactLattice &clat,
 }
 
 
+// Closed grammar result without word timings requested: the one-best path is
+// read straight from the lattice, skipping word alignment and MBR. Times are
+// approximate. The confidence of every word is the posterior of the whole
+// path, which takes one forward pass instead of MBR and is never above the
+// posterior of any of its words
+void Recognizer::OneBestWords(CompactLattice &rlat)
+{
+    CompactLattice best_path;
+    CompactLatticeShortestPath(rlat, &best_path);
+
+    result_.text.clear();
+    result_.words.clear();
+
+    // The best path is linear, the length of the transition-id string of an
+    // arc is the number of frames it covers
+    int32 cur_time = 0;
+    double best_cost = 0.0;
+    CompactLattice::StateId state = best_path.Start();
+    while (state != fst::kNoStateId && best_path.NumArcs(state) == 1) {
+        fst::ArcIterator<CompactLattice> aiter(best_path, state);
+        const CompactLatticeArc &arc = aiter.Value();
+        int32 length = arc.weight.String().size();
+        best_cost += arc.weight.Weight().Value1() + arc.weight.Weight().Value2();
+
+        if (arc.ilabel != 0) {
+            const string &word = model_->word_syms_->Find(arc.ilabel);
+            if (!result_.words.empty()) {
+                result_.text += " ";
+            }
+
+            RecognizerWord w;
+            w.id = arc.ilabel;
+            w.text_start = result_.text.size();
+            w.text_length = word.size();
+            w.start = samples_round_start_ / sample_frequency_ + (frame_offset_ + cur_time) * 0.03;
+            w.end = samples_round_start_ / sample_frequency_ + (frame_offset_ + cur_time + length) * 0.03;
+            result_.words.push_back(w);
+
+            result_.text += word;
+        }
+
+        cur_time += length;
+        state = arc.nextstate;
+    }
+    if (state != fst::kNoStateId) {
+        const CompactLatticeWeight &final_weight = best_path.Final(state);
+        best_cost += final_weight.Weight().Value1() + final_weight.Weight().Value2();
+    }
+
+    // Total log-probability of the lattice, the alphas are negated costs
+    BaseFloat conf = 1.0;
+    vector<double> alpha;
+    TopSortCompactLatticeIfNeeded(&rlat);
+    if (ComputeCompactLatticeAlphas(rlat, &alpha)) {
+        double total = -std::numeric_limits<double>::infinity();
+        for (CompactLattice::StateId s = 0; s < rlat.NumStates(); s++) {
+            const CompactLatticeWeight &final_weight = rlat.Final(s);
+            if (final_weight != CompactLatticeWeight::Zero()) {
+                total = LogAdd(total, alpha[s] - (final_weight.Weight().Value1() + final_weight.Weight().Value2()));
+            }
+        }
+        conf = std::min(1.0, exp(-best_cost - total));
+    }
+    for (RecognizerWord &w : result_.words) {
+        w.conf = conf;
+    }
+}
+
+void Recognizer::ResultWords(CompactLattice &rlat)
+{
+    if (closed_grammar_ && !words_) {
+        OneBestWords(rlat);
+    } else {
+        MbrWords(rlat);
+    }
+}
+
 const char *Recognizer::NbestResult(CompactLattice &clat)
 {
     Lattice lat;
@@ -778,11 +1164,31 @@ const char* Recognizer::GetResult()
         return StoreEmptyReturn();
     }
 
+    CompactLattice rlat;
+    if (!GetRescoredLattice(&rlat)) {
+        return StoreEmptyReturn();
+    }
+
+    if (max_alternatives_ == 0) {
+        return MbrResult(rlat);
+    } else if (nlsml_) {
+        return NlsmlResult(rlat);
+    } else {
+        return NbestResult(rlat);
+    }
+
+}
+
+bool Recognizer::GetRescoredLattice(CompactLattice *out_lat)
+{
     // Original from decoder, subtracted graph weight, rescored with carpa, rescored with rnnlm
     CompactLattice clat, slat, tlat, rlat;
 
     clat = decoder_->GetLattice(decoder_->NumFramesDecoded(), true);
 
+    if (!closed_grammar_ && !rescoring_ready_) {
+        InitRescoring();
+    }
     if (lm_to_subtract_ && carpa_to_add_) {
         Lattice lat, composed_lat;
 
@@ -818,25 +1224,21 @@ const char* Recognizer::GetResult()
 
     // Pruned composition can return empty lattice. It should be rare
     if (rlat.Start() != 0) {
-       return StoreEmptyReturn();
+       return false;
     }
 
     // Apply rescoring weight
     fst::ScaleLattice(fst::GraphLatticeScale(0.9), &rlat);
 
-    if (max_alternatives_ == 0) {
-        return MbrResult(rlat);
-    } else if (nlsml_) {
-        return NlsmlResult(rlat);
-    } else {
-        return NbestResult(rlat);
-    }
-
+    *out_lat = rlat;
+    return true;
 }
 
 
 const char* Recognizer::PartialResult()
 {
+    WaitWorker();
+
     if (state_ != RECOGNIZER_RUNNING) {
         return StoreEmptyReturn();
     }
@@ -913,6 +1315,8 @@ const char* Recognizer::PartialResult()
 
 const char* Recognizer::Result()
 {
+    WaitWorker();
+
     if (state_ != RECOGNIZER_RUNNING) {
         return StoreEmptyReturn();
     }
@@ -921,8 +1325,31 @@ const char* Recognizer::Result()
     return GetResult();
 }
 
+// Same as Result() but fills result_ with the words instead of producing JSON
+const RecognizerResult &Recognizer::StructuredResult()
+{
+    WaitWorker();
+
+    result_.text.clear();
+    result_.words.clear();
+
+    if (state_ != RECOGNIZER_RUNNING) {
+        return result_;
+    }
+    decoder_->FinalizeDecoding();
+    state_ = RECOGNIZER_ENDPOINT;
+
+    CompactLattice rlat;
+    if (decoder_->NumFramesDecoded() > 0 && GetRescoredLattice(&rlat)) {
+        ResultWords(rlat);
+    }
+    return result_;
+}
+
 const char* Recognizer::FinalResult()
 {
+    WaitWorker();
+
     if (state_ != RECOGNIZER_RUNNING) {
         return StoreEmptyReturn();
     }
@@ -951,6 +1378,8 @@ const char* Recognizer::FinalResult()
 
 void Recognizer::Reset()
 {
+    WaitWorker();
+
     if (state_ == RECOGNIZER_RUNNING) {
         decoder_->FinalizeDecoding();
     }
@@ -958,6 +1387,87 @@ void Recognizer::Reset()
     state_ = RECOGNIZER_ENDPOINT;
 }
 
+void Recognizer::Rearm()
+{
+    // Don't finalize the dropped utterance, its result is not needed. Switching to
+    // the endpoint state makes the next AcceptWaveform go through CleanUp(), which
+    // restarts decoding on the existing decoder and feature pipeline after the
+    // frames already extracted. The chunks still queued for the worker thread
+    // belong to the dropped utterance too
+    if (worker_.joinable()) {
+        std::unique_lock<std::mutex> lock(worker_mutex_);
+        while (!chunks_.empty()) {
+            free_chunks_.push_back(std::move(chunks_.front()));
+            chunks_.pop_front();
+        }
+        caller_cv_.wait(lock, [this] { return !worker_busy_; });
+    }
+
+    if (state_ == RECOGNIZER_RUNNING) {
+        state_ = RECOGNIZER_ENDPOINT;
+    }
+    if (state_ == RECOGNIZER_ENDPOINT) {
+        rearmed_ = true;
+    }
+    StoreEmptyReturn();
+}
+
+// With a closed grammar the utterance can be complete before the trailing
+// silence. Signal the endpoint once the best partial hypothesis is a whole
+// grammar sentence, every word has at least the configured confidence and
+// the hypothesis stayed the same for the configured number of chunks
+bool Recognizer::EarlyCommitDetected()
+{
+    if (!grammar_graph_ || decoder_->NumFramesInLattice() == 0) {
+        early_commit_count_ = 0;
+        return false;
+    }
+
+    // The best path is cheap, the lattice and MBR are only computed for the
+    // confidences once it is a whole grammar sentence
+    Lattice best_path;
+    decoder_->GetBestPath(false, &best_path);
+    vector<int32> alignment, words;
+    LatticeWeight weight;
+    GetLinearSymbolSequence(best_path, &alignment, &words, &weight);
+
+    // A sentence that a longer one extends ("velocidade vinte" and "velocidade
+    // vinte e cinco") can still grow, it is left to the endpoint
+    bool complete = !words.empty() && grammar_graph_->HasSentence(words) &&
+                    !grammar_graph_->HasLongerSentence(words);
+
+    if (complete && early_commit_confidence_ > 0) {
+        CompactLattice clat;
+        CompactLattice aligned_lat;
+
+        clat = decoder_->GetLattice(decoder_->NumFramesInLattice(), false);
+        if (model_->winfo_) {
+            WordAlignLatticePartial(clat, *model_->trans_model_, *model_->winfo_, 0, &aligned_lat);
+        } else {
+            CopyLatticeForMbr(clat, &aligned_lat);
+        }
+
+        MinimumBayesRisk mbr(aligned_lat);
+        const vector<BaseFloat> &conf = mbr.GetOneBestConfidences();
+        complete = mbr.GetOneBest() == words;
+        for (size_t i = 0; complete && i < conf.size(); i++) {
+            if (conf[i] < early_commit_confidence_)
+                complete = false;
+        }
+    }
+
+    if (!complete) {
+        early_commit_count_ = 0;
+        return false;
+    }
+
+    if (early_commit_count_ == 0 || words != early_commit_words_) {
+        early_commit_words_ = words;
+        early_commit_count_ = 0;
+    }
+    return ++early_commit_count_ >= early_commit_chunks_;
+}
+
 const char *Recognizer::StoreEmptyReturn()
 {
     if (!max_alternatives_) {
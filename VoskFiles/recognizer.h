@@ -31,6 +31,12 @@
 #include "model.h"
 #include "spk_model.h"
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
 using namespace kaldi;
 
 enum RecognizerState {
@@ -40,6 +46,21 @@ enum RecognizerState {
     RECOGNIZER_FINALIZED
 };
 
+// Utterance result without JSON serialization, see vosk_recognizer_get_result
+struct RecognizerWord {
+    int32 id;
+    int text_start;  // position of the word in RecognizerResult::text
+    int text_length;
+    BaseFloat conf;
+    BaseFloat start;
+    BaseFloat end;
+};
+
+struct RecognizerResult {
+    string text;
+    vector<RecognizerWord> words;
+};
+
 class Recognizer {
     public:
         Recognizer(Model *model, float sample_frequency);
@@ -49,28 +70,48 @@ class Recognizer {
         void SetMaxAlternatives(int max_alternatives);
         void SetSpkModel(SpkModel *spk_model);
         void SetGrm(char const *grammar);
+        bool SetGrammarContext(char const *name);
         void SetWords(bool words);
         void SetPartialWords(bool partial_words);
         void SetNLSML(bool nlsml);
         void SetEndpointerMode(int mode);
         void SetEndpointerDelays(float t_start_max, float t_end, float t_max);
+        void SetEarlyCommit(float min_confidence, int stable_chunks);
+        void SetClosedGrammar(bool closed_grammar);
+        void SetAlwaysOn(bool always_on);
+        void SetWorkerThread(bool worker_thread);
         bool AcceptWaveform(const char *data, int len);
         bool AcceptWaveform(const short *sdata, int len);
         bool AcceptWaveform(const float *fdata, int len);
         const char* Result();
         const char* FinalResult();
         const char* PartialResult();
+        const RecognizerResult &StructuredResult();
         void Reset();
+        void Rearm();
 
     private:
         void InitState();
         void InitRescoring();
+        void FreeRescoring();
         void CleanUp();
         void UpdateSilenceWeights();
         void UpdateGrammarFst(char const *grammar);
-        bool AcceptWaveform(Vector<BaseFloat> &wdata);
+        void SwitchGrammarGraph();
+        const fst::Fst<fst::StdArc> &GrammarFst() const;
+        bool EarlyCommitDetected();
+        bool AcceptWaveform(const VectorBase<BaseFloat> &wdata);
+        bool DecodeChunk(const VectorBase<BaseFloat> &wdata);
+        bool QueueChunk(const VectorBase<BaseFloat> &wdata);
+        void WorkerLoop();
+        void WaitWorker();
+        void StopWorker();
         bool GetSpkVector(Vector<BaseFloat> &out_xvector, int *frames);
         const char *GetResult();
+        bool GetRescoredLattice(CompactLattice *rlat);
+        void ResultWords(CompactLattice &clat);
+        void MbrWords(CompactLattice &clat);
+        void OneBestWords(CompactLattice &clat);
         const char *StoreEmptyReturn();
         const char *StoreReturn(const string &res);
         const char *MbrResult(CompactLattice &clat);
@@ -80,12 +121,20 @@ class Recognizer {
         Model *model_ = nullptr;
         SingleUtteranceNnet3IncrementalDecoder *decoder_ = nullptr;
         fst::LookaheadFst<fst::StdArc, int32> *decode_fst_ = nullptr;
-        fst::StdVectorFst *g_fst_ = nullptr; // dynamically constructed grammar
+        GrammarGraph *grammar_graph_ = nullptr; // dynamically constructed grammar, shared through the model
+        GrammarGraph *pending_graph_ = nullptr; // grammar context to switch to at the next utterance boundary
         OnlineNnet2FeaturePipeline *feature_pipeline_ = nullptr;
         OnlineSilenceWeighting *silence_weighting_ = nullptr;
+        std::vector<BaseFloat> wave_buffer_; // int16 -> float conversion, reused between calls
         // Endpointer
         kaldi::OnlineEndpointConfig endpoint_config_;
 
+        // Early commit of complete grammar sentences, disabled by default
+        float early_commit_confidence_ = 0.0;
+        int early_commit_chunks_ = 0;
+        int early_commit_count_ = 0;
+        vector<int32> early_commit_words_;
+
         // Speaker identification
         SpkModel *spk_model_ = nullptr;
         OnlineBaseFeature *spk_feature_ = nullptr;
@@ -98,6 +147,26 @@ class Recognizer {
         kaldi::rnnlm::KaldiRnnlmDeterministicFst* rnnlm_to_add_ = nullptr;
         fst::DeterministicOnDemandFst<fst::StdArc> *rnnlm_to_add_scale_ = nullptr;
         kaldi::rnnlm::RnnlmComputeStateInfo *rnnlm_info_ = nullptr;
+        // Closed grammar profile: no rescoring, one-best without MBR unless words are requested
+        bool closed_grammar_ = false;
+        bool rescoring_ready_ = false; // rescoring models built, see InitRescoring()
+        // Always-on mode: the feature pipeline and decoder are never rebuilt between utterances
+        bool always_on_ = false;
+        // Rearm() dropped the utterance, the next one starts after the frames already in the pipeline
+        bool rearmed_ = false;
+
+        // Worker thread mode: AcceptWaveform() queues the audio and a dedicated thread
+        // runs feature extraction, the nnet3 computation and the search on it
+        std::thread worker_;
+        std::mutex worker_mutex_;
+        std::condition_variable worker_cv_; // chunk queued or stop requested
+        std::condition_variable caller_cv_; // chunk taken or finished
+        std::deque<std::vector<BaseFloat> > chunks_;
+        std::vector<std::vector<BaseFloat> > free_chunks_; // buffers of decoded chunks, reused
+        bool worker_busy_ = false;
+        bool worker_stop_ = false;
+        bool worker_endpoint_ = false; // endpoint detected in the decoded chunks of this utterance
+        std::exception_ptr worker_error_;
 
 
         // Other
@@ -114,6 +183,7 @@ class Recognizer {
 
         RecognizerState state_;
         string last_result_;
+        RecognizerResult result_;
 };
 
 #endif /* VOSK_KALDI_RECOGNIZER_H */
@@ -0,0 +1,168 @@
+#include "audio_capture.h"
+
+#include <algorithm>
+#include <iostream>
+#include <unistd.h>
+
+AudioRingBuffer::AudioRingBuffer()
+    : buffer_(RING_CAPACITY), write_index_(0), closed_(false) {}
+
+AudioWindow AudioRingBuffer::window(uint64_t index, size_t length) const {
+    size_t start = static_cast<size_t>(index & (RING_CAPACITY - 1));
+    size_t first_len = std::min(length, static_cast<size_t>(RING_CAPACITY) - start);
+
+    AudioWindow w;
+    w.first = buffer_.data() + start;
+    w.first_len = first_len;
+    w.second = buffer_.data();
+    w.second_len = length - first_len;
+    return w;
+}
+
+bool AudioRingBuffer::wait_for(uint64_t end) {
+    if (write_index() >= end) return true;
+
+    std::unique_lock<std::mutex> lock(wait_mutex_);
+    wait_cv_.wait(lock, [&] {
+        return write_index() >= end || closed_.load(std::memory_order_acquire);
+    });
+    return write_index() >= end;
+}
+
+int16_t* AudioRingBuffer::write_region(size_t* max_len) {
+    size_t start = static_cast<size_t>(write_index_.load(std::memory_order_relaxed) & (RING_CAPACITY - 1));
+    *max_len = static_cast<size_t>(RING_CAPACITY) - start;
+    return buffer_.data() + start;
+}
+
+void AudioRingBuffer::commit(size_t count) {
+    write_index_.fetch_add(count, std::memory_order_release);
+    {
+        // O mutex só serve para não perder a notificação; os dados não passam por ele
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+    }
+    wait_cv_.notify_all();
+}
+
+void AudioRingBuffer::close() {
+    closed_.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+    }
+    wait_cv_.notify_all();
+}
+
+AudioCapture::AudioCapture(snd_pcm_t* pcm_handle)
+    : pcm_handle_(pcm_handle), running_(false), xruns_(0) {}
+
+AudioCapture::~AudioCapture() {
+    stop();
+    if (pcm_handle_) snd_pcm_close(pcm_handle_);
+}
+
+bool AudioCapture::start() {
+    if (running_.load()) return true;
+    if (!pcm_handle_) return false;
+
+    running_.store(true);
+    thread_ = std::thread(&AudioCapture::run, this);
+    return true;
+}
+
+void AudioCapture::stop() {
+    running_.store(false);
+    if (thread_.joinable()) thread_.join();
+    ring_.close();
+}
+
+void AudioCapture::run() {
+    while (running_.load(std::memory_order_relaxed)) {
+        size_t max_len;
+        int16_t* region = ring_.write_region(&max_len);
+        snd_pcm_uframes_t frames = std::min(max_len, static_cast<size_t>(CAPTURE_PERIOD));
+
+        snd_pcm_sframes_t n = snd_pcm_readi(pcm_handle_, region, frames);
+        if (n > 0) {
+            ring_.commit(static_cast<size_t>(n));
+            continue;
+        }
+
+        if (n == -EAGAIN) continue;
+
+        if (n == -EPIPE) {
+            xruns_.fetch_add(1, std::memory_order_relaxed);
+            std::cerr << "[WARN] XRUN na captura de áudio (" << xrun_count() << " no total). Recuperando...\n";
+        }
+
+        int err = snd_pcm_recover(pcm_handle_, static_cast<int>(n), 1);
+        if (err >= 0) continue;
+
+        std::cerr << "[ERRO] Falha ao recuperar captura de áudio: " << snd_strerror(err) << ". Reabrindo dispositivo...\n";
+        snd_pcm_close(pcm_handle_);
+        pcm_handle_ = init_audio();
+        if (!pcm_handle_) {
+            std::cerr << "[ERRO] Captura de áudio encerrada.\n";
+            break;
+        }
+    }
+
+    running_.store(false);
+    ring_.close();
+}
+
+snd_pcm_t* init_audio() {
+    snd_pcm_t *pcm_handle = nullptr;
+    snd_pcm_hw_params_t *params = nullptr;
+    snd_pcm_uframes_t period = CAPTURE_PERIOD;
+    int err;
+
+    std::cout << "[INFO] Inicializando captura de áudio ALSA em \"" << PCM_DEVICE << "\"..." << std::endl;
+
+    for (int attempt = 1; attempt <= MAX_ATTEMPTS; ++attempt) {
+        err = snd_pcm_open(&pcm_handle, PCM_DEVICE, SND_PCM_STREAM_CAPTURE, 0);
+        if (err >= 0) {
+            std::cout << "[INFO] Microfone aberto na tentativa " << attempt << " de " << MAX_ATTEMPTS << "." << std::endl;
+
+            if ((err = snd_pcm_hw_params_malloc(&params)) < 0) {
+                std::cerr << "[ERRO] Falha ao alocar hw_params: " << snd_strerror(err) << std::endl;
+                snd_pcm_close(pcm_handle);
+                return nullptr;
+            }
+
+            if ((err = snd_pcm_hw_params_any(pcm_handle, params)) < 0 ||
+                (err = snd_pcm_hw_params_set_access(pcm_handle, params, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0 ||
+                (err = snd_pcm_hw_params_set_format(pcm_handle, params, SND_PCM_FORMAT_S16_LE)) < 0 ||
+                (err = snd_pcm_hw_params_set_channels(pcm_handle, params, CHANNELS)) < 0 ||
+                (err = snd_pcm_hw_params_set_rate(pcm_handle, params, SAMPLE_RATE, 0)) < 0 ||
+                (err = snd_pcm_hw_params_set_period_size_near(pcm_handle, params, &period, 0)) < 0 ||
+                (err = snd_pcm_hw_params(pcm_handle, params)) < 0) {
+
+                std::cerr << "[ERRO] Falha ao configurar hw_params: " << snd_strerror(err) << std::endl;
+                snd_pcm_hw_params_free(params);
+                snd_pcm_close(pcm_handle);
+                return nullptr;
+            }
+
+            snd_pcm_hw_params_free(params);
+
+            if ((err = snd_pcm_prepare(pcm_handle)) < 0) {
+                std::cerr << "[ERRO] Falha ao preparar PCM: " << snd_strerror(err) << std::endl;
+                snd_pcm_close(pcm_handle);
+                return nullptr;
+            }
+
+            std::cout << "[INFO] Áudio configurado para " << SAMPLE_RATE << " Hz, " << CHANNELS << " canal(is), formato S16_LE." << std::endl;
+            return pcm_handle;
+        }
+
+        std::cerr << "[WARN] Tentativa " << attempt << " falhou: " << snd_strerror(err) << std::endl;
+
+        if (attempt < MAX_ATTEMPTS) {
+            std::cerr << "[INFO] Aguardando " << DELAY << "ms antes de tentar novamente...\n";
+            usleep(DELAY * 1000);
+        }
+    }
+
+    std::cerr << "[ERRO] Não foi possível inicializar o microfone após " << MAX_ATTEMPTS << " tentativas.\n";
+    return nullptr;
+}
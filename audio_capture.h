@@ -0,0 +1,128 @@
+#ifndef AUDIO_CAPTURE_H
+#define AUDIO_CAPTURE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <alsa/asoundlib.h>
+
+#define SAMPLE_RATE     16000                               // Taxa de amostragem do microfone
+#define CHANNELS        1                                   // Mono
+#define PCM_DEVICE      "default"                           // Dispositivo de áudio ALSA padrão
+#define MAX_ATTEMPTS    10                                  // Tentativa para conectar ao microfone
+#define DELAY           5000                                // ms de delay entre tentativas
+#define RING_CAPACITY   (1u << 17)                          // Amostras no buffer circular (~8,2 s a 16 kHz, potência de 2)
+#define CAPTURE_PERIOD  512                                 // Amostras lidas do ALSA por chamada (32 ms)
+
+/*
+*   Janela de áudio dentro do buffer circular, sem cópia.
+*   Quando a janela cruza o fim do buffer ela é composta por dois trechos contíguos.
+*/
+struct AudioWindow {
+    const int16_t* first;
+    size_t first_len;
+    const int16_t* second;
+    size_t second_len;
+
+    size_t size() const { return first_len + second_len; }
+    int16_t at(size_t i) const { return i < first_len ? first[i] : second[i - first_len]; }
+};
+
+/*
+*   Buffer circular lock-free de amostras int16, um produtor e vários consumidores.
+*
+*   O produtor (thread de captura) publica amostras avançando write_index, que conta o total de
+*   amostras já escritas desde o início. Cada consumidor mantém o seu próprio cursor (índice absoluto
+*   de amostra) e lê janelas diretamente do buffer. Um consumidor que ficar mais de RING_CAPACITY
+*   amostras atrás do produtor perde dados; isso é detectado com is_intact().
+*/
+class AudioRingBuffer {
+public:
+    AudioRingBuffer();
+
+    /*
+    *   Retorna o índice absoluto da próxima amostra a ser escrita (total de amostras publicadas).
+    */
+    uint64_t write_index() const { return write_index_.load(std::memory_order_acquire); }
+
+    /*
+    *   Retorna a janela [index, index + length) sem copiar os dados.
+    *   Só é válida se index + length <= write_index() e a janela ainda estiver intacta.
+    */
+    AudioWindow window(uint64_t index, size_t length) const;
+
+    /*
+    *   Verifica se a amostra index ainda não foi sobrescrita pelo produtor.
+    *   Deve ser chamada após consumir uma janela para confirmar que os dados lidos eram válidos.
+    *   Considera também o período que o produtor pode estar escrevendo neste momento.
+    */
+    bool is_intact(uint64_t index) const { return write_index() + CAPTURE_PERIOD - index <= RING_CAPACITY; }
+
+    /*
+    *   Bloqueia até que existam amostras até end (exclusivo) ou até a captura ser encerrada.
+    *
+    *   @return true se as amostras estão disponíveis, false se a captura foi encerrada.
+    */
+    bool wait_for(uint64_t end);
+
+    /*
+    *   Região contígua onde o produtor pode escrever diretamente (usada pelo snd_pcm_readi).
+    */
+    int16_t* write_region(size_t* max_len);
+
+    /*
+    *   Publica count amostras escritas na região retornada por write_region() e acorda os consumidores.
+    */
+    void commit(size_t count);
+
+    /*
+    *   Encerra o buffer, liberando consumidores bloqueados em wait_for().
+    */
+    void close();
+
+private:
+    std::vector<int16_t> buffer_;
+    std::atomic<uint64_t> write_index_;
+    std::atomic<bool> closed_;
+    std::mutex wait_mutex_;
+    std::condition_variable wait_cv_;
+};
+
+/*
+*   Thread dedicada de captura ALSA que alimenta um AudioRingBuffer continuamente.
+*   Trata XRUN (overrun) e suspensão via snd_pcm_recover e reabre o dispositivo se a recuperação falhar.
+*   Assume a posse do pcm_handle, que é fechado no destrutor.
+*/
+class AudioCapture {
+public:
+    explicit AudioCapture(snd_pcm_t* pcm_handle);
+    ~AudioCapture();
+
+    bool start();
+    void stop();
+
+    AudioRingBuffer& ring() { return ring_; }
+    uint64_t xrun_count() const { return xruns_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    snd_pcm_t* pcm_handle_;
+    AudioRingBuffer ring_;
+    std::thread thread_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> xruns_;
+};
+
+/*
+*   Inicializa o dispositivo de áudio ALSA e configura os parâmetros necessários.
+*
+*   @return snd_pcm_t* Ponteiro para o dispositivo de áudio ALSA ou nullptr em caso de erro.
+*/
+snd_pcm_t* init_audio();
+
+#endif
@@ -0,0 +1,128 @@
+#include "commands.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+bool CommandTable::load(const char* path, VoskModel* model) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "[ERRO] Não foi possível abrir a tabela de comandos \"" << path << "\".\n";
+        return false;
+    }
+
+    commands_.clear();
+    word_ids_.clear();
+    index_.clear();
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        ++line_number;
+        if (line.empty() || line[0] == '#') continue;
+
+        std::stringstream fields(line);
+        std::string phrase, action, value;
+        Command command;
+        if (!std::getline(fields, phrase, ';') || !std::getline(fields, action, ';') ||
+            !std::getline(fields, value, ';')) {
+            std::cerr << "[WARN] Linha " << line_number << " da tabela de comandos mal formada. Ignorando.\n";
+            continue;
+        }
+        std::getline(fields, command.message);
+
+        if (action == "motor") command.action = CommandAction::MOTOR;
+        else if (action == "rabeta") command.action = CommandAction::TAIL;
+        else if (action == "nenhuma") command.action = CommandAction::NONE;
+        else {
+            std::cerr << "[WARN] Ação \"" << action << "\" desconhecida na linha " << line_number << ". Ignorando.\n";
+            continue;
+        }
+        command.value = std::atoi(value.c_str());
+
+        // Normaliza a frase (um espaço entre palavras) e resolve os ids de palavra
+        std::stringstream words(phrase);
+        std::string word;
+        std::vector<int> ids;
+        bool in_vocabulary = true;
+        while (words >> word) {
+            int id = vosk_model_find_word(model, word.c_str());
+            if (id < 0) {
+                std::cerr << "[WARN] Palavra \"" << word << "\" fora do vocabulário do modelo (linha "
+                          << line_number << "). Ignorando comando.\n";
+                in_vocabulary = false;
+                break;
+            }
+            if (!command.phrase.empty()) command.phrase += ' ';
+            command.phrase += word;
+            ids.push_back(id);
+        }
+        if (!in_vocabulary || ids.empty()) continue;
+        if (ids.size() > MAX_COMMAND_WORDS) {
+            std::cerr << "[WARN] Frase da linha " << line_number << " tem mais de " << MAX_COMMAND_WORDS
+                      << " palavras. Ignorando.\n";
+            continue;
+        }
+
+        uint64_t hash = hash_ids(ids.data(), ids.size());
+        if (index_.count(hash)) {
+            std::cerr << "[WARN] Frase \"" << command.phrase << "\" repetida ou em conflito (linha "
+                      << line_number << "). Ignorando.\n";
+            continue;
+        }
+
+        index_[hash] = commands_.size();
+        commands_.push_back(command);
+        word_ids_.push_back(ids);
+    }
+
+    std::cout << "[INFO] " << commands_.size() << " comandos carregados de \"" << path << "\".\n";
+    return !commands_.empty();
+}
+
+std::string CommandTable::grammar() const {
+    std::string json = "[";
+    for (size_t i = 0; i < commands_.size(); ++i) {
+        if (i) json += ", ";
+        json += '"';
+        for (char c : commands_[i].phrase) {
+            if (c == '"' || c == '\\') json += '\\';
+            json += c;
+        }
+        json += '"';
+    }
+    json += "]";
+    return json;
+}
+
+const Command* CommandTable::find(const VoskWord* words, int num_words) const {
+    if (num_words <= 0 || num_words > MAX_COMMAND_WORDS) return nullptr;
+
+    int ids[MAX_COMMAND_WORDS];
+    for (int i = 0; i < num_words; ++i) ids[i] = words[i].id;
+
+    auto it = index_.find(hash_ids(ids, num_words));
+    if (it == index_.end()) return nullptr;
+
+    // Confirma a sequência para não aceitar uma colisão de hash
+    const std::vector<int>& expected = word_ids_[it->second];
+    if (expected.size() != static_cast<size_t>(num_words)) return nullptr;
+    for (int i = 0; i < num_words; ++i) {
+        if (expected[i] != ids[i]) return nullptr;
+    }
+    return &commands_[it->second];
+}
+
+uint64_t CommandTable::hash_ids(const int* ids, size_t count) {
+    // FNV-1a sobre os ids de palavra
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t id = static_cast<uint32_t>(ids[i]);
+        for (int byte = 0; byte < 4; ++byte) {
+            hash ^= (id >> (8 * byte)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
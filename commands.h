@@ -0,0 +1,72 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <vosk_api.h>
+
+#define MAX_COMMAND_WORDS   8                               // Palavras máximas de uma frase de comando
+
+/*
+*   Ação CAN executada por um comando de voz.
+*/
+enum class CommandAction {
+    MOTOR,      // Duty cycle do motor (MIC), valor em % (0 desliga)
+    TAIL,       // Posição da rabeta (MDE), valor em centésimos de grau
+    NONE,       // Só entra na gramática, é tratado como comando não reconhecido
+};
+
+struct Command {
+    std::string phrase;     // Frase falada, palavras separadas por um espaço
+    CommandAction action;
+    int value;
+    std::string message;    // Mensagem de log ao executar o comando
+};
+
+/*
+*   Tabela de comandos de voz carregada de arquivo.
+*
+*   A mesma tabela gera a gramática do Vosk e resolve o resultado do reconhecedor: cada frase é
+*   indexada pela sequência de ids de palavra do modelo, então o despacho é uma busca em hash,
+*   sem comparar texto.
+*
+*   Formato do arquivo, uma frase por linha (linhas vazias e iniciadas por # são ignoradas):
+*       frase;acao;valor;mensagem
+*   com acao "motor", "rabeta" ou "nenhuma". Ex.: velocidade dez;motor;10;Ajustando velocidade do motor para 10%.
+*/
+class CommandTable {
+public:
+    /*
+    *   Carrega a tabela do arquivo e indexa as frases pelos ids de palavra do modelo.
+    *   Frases com palavras fora do vocabulário do modelo são descartadas com aviso.
+    *
+    *   @return true se ao menos um comando foi carregado.
+    */
+    bool load(const char* path, VoskModel* model);
+
+    /*
+    *   Gramática do Vosk (array JSON com as frases da tabela).
+    */
+    std::string grammar() const;
+
+    /*
+    *   Busca o comando correspondente às palavras reconhecidas.
+    *
+    *   @return Comando ou nullptr se a sequência não for uma frase da tabela.
+    */
+    const Command* find(const VoskWord* words, int num_words) const;
+
+    size_t size() const { return commands_.size(); }
+
+private:
+    static uint64_t hash_ids(const int* ids, size_t count);
+
+    std::vector<Command> commands_;
+    std::vector<std::vector<int>> word_ids_;                // Ids de palavra de cada comando
+    std::unordered_map<uint64_t, size_t> index_;            // Hash da sequência de ids -> comando
+};
+
+#endif
@@ -95,6 +95,12 @@
     #define ESP_NN                                  1
 #endif
 
+// Keep EON compiled graphs initialized between inferences (arena, op user data and Prepare are
+// done once); set to 0 to initialize and reset the graph around every invoke
+#ifndef EI_CLASSIFIER_TFLITE_EON_PERSISTENT_SESSION
+#define EI_CLASSIFIER_TFLITE_EON_PERSISTENT_SESSION   1
+#endif // EI_CLASSIFIER_TFLITE_EON_PERSISTENT_SESSION
+
 // no include checks in the compiler? then just include metadata and then ops_define (optional if on EON model)
 #ifndef __has_include
     #include "model-parameters/model_metadata.h"
@@ -216,6 +216,18 @@ typedef struct {
      * `EI_CLASSIFIER_HAS_ANOMALY == 1`.
      */
     int64_t anomaly_us;
+
+    /**
+     * Time spent initializing the inference engine (arena allocation, op registration, Prepare).
+     * For learn blocks it is part of `classification_us`, for EON graphs run as DSP blocks part
+     * of `dsp_us`. Zero when persistent EON sessions are reused.
+     */
+    int64_t classification_init_us;
+
+    /**
+     * Part of `classification_us` spent in the model invoke itself
+     */
+    int64_t classification_invoke_us;
 } ei_impulse_result_timing_t;
 
 /**
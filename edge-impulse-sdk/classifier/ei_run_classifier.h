@@ -396,6 +396,9 @@ extern "C" EI_IMPULSE_ERROR process_impulse(ei_impulse_handle_t *handle,
 
     result->timing.dsp_us = ei_read_timer_us() - dsp_start_us;
     result->timing.dsp = (int)(result->timing.dsp_us / 1000);
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+    result->timing.classification_init_us = ei_tflite_eon_take_dsp_init_us();
+#endif
 
     if (debug) {
         ei_printf("Features (%d ms.): ", result->timing.dsp);
@@ -525,6 +528,10 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
             return EI_IMPULSE_CANCELED;
         }
 
+        if (block.extract_fn == extract_mfcc_features) {
+            ei_dsp_cont_mfcc_cmvnw_push(&fm, block.config, &features_written);
+        }
+
         classifier_continuous_features_written += (features_written.rows * features_written.cols);
 
         out_features_index += block.n_output_features;
@@ -585,7 +592,7 @@ extern "C" EI_IMPULSE_ERROR process_impulse_continuous(ei_impulse_handle_t *hand
             }
 
             if (block.extract_fn == extract_mfcc_features) {
-                calc_cepstral_mean_and_var_normalization_mfcc(features[ix].matrix, block.config);
+                calc_cepstral_mean_and_var_normalization_mfcc_continuous(features[ix].matrix, block.config);
             }
             else if (block.extract_fn == extract_spectrogram_features) {
                 calc_cepstral_mean_and_var_normalization_spectrogram(features[ix].matrix, block.config);
@@ -863,6 +870,23 @@ __attribute__((unused)) void run_classifier_init(ei_impulse_handle_t *handle)
 #endif
 }
 
+/**
+ * @brief Discard the sliding window kept by `run_classifier_continuous()`.
+ *
+ * Clears the features written so far and the partial DSP frame, without re-initializing
+ * the impulse or the postprocessing state. Call this after a detection, or whenever the
+ * audio stream is interrupted, so the next inference only sees slices received afterwards.
+ * A full window (`EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW` slices) is needed before the next
+ * inference runs.
+ *
+ * **Blocking**: yes
+ */
+extern "C" void run_classifier_flush(void)
+{
+    classifier_continuous_features_written = 0;
+    ei_dsp_clear_continuous_audio_state();
+}
+
 /**
  * @brief Deletes static variables when running preprocessing and inference continuously.
  *
@@ -877,6 +901,9 @@ __attribute__((unused)) void run_classifier_init(ei_impulse_handle_t *handle)
 extern "C" void run_classifier_deinit(void)
 {
     deinit_postprocessing(&ei_default_impulse);
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+    ei_tflite_eon_close_sessions();
+#endif
 }
 
 __attribute__((unused)) void run_classifier_deinit(ei_impulse_handle_t *handle)
@@ -885,6 +912,9 @@ __attribute__((unused)) void run_classifier_deinit(ei_impulse_handle_t *handle)
 #if EI_CLASSIFIER_HAS_DATA_NORMALIZATION
     deinit_data_normalization(handle);
 #endif
+#if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) && (EI_CLASSIFIER_COMPILED == 1)
+    ei_tflite_eon_close_sessions();
+#endif
 }
 
 /**
@@ -77,6 +77,12 @@ static float *ei_dsp_cont_current_frame = nullptr;
 static size_t ei_dsp_cont_current_frame_size = 0;
 static int ei_dsp_cont_current_frame_ix = 0;
 
+#if EIDSP_CMVNW_INCREMENTAL == 1
+// running sums for the MFCC normalization in continuous mode (one MFCC block)
+static speechpy::processing::cmvnw_running ei_dsp_cont_mfcc_cmvnw;
+static void *ei_dsp_cont_mfcc_cmvnw_config = nullptr;
+#endif
+
 __attribute__((unused)) int extract_hr_features(
     signal_t *signal,
     matrix_t *output_matrix,
@@ -1383,6 +1389,10 @@ __attribute__((unused)) int ei_dsp_clear_continuous_audio_state() {
     ei_dsp_cont_current_frame_size = 0;
     ei_dsp_cont_current_frame_ix = 0;
 
+#if EIDSP_CMVNW_INCREMENTAL == 1
+    ei_dsp_cont_mfcc_cmvnw.clear();
+#endif
+
     return EIDSP_OK;
 }
 
@@ -1414,6 +1424,94 @@ __attribute__((unused)) void calc_cepstral_mean_and_var_normalization_mfcc(ei_ma
     matrix->cols = original_matrix_size;
 }
 
+/**
+ * @brief      Adds the MFCC rows written by a continuous slice to the running
+ *             normalization sums used by calc_cepstral_mean_and_var_normalization_mfcc_continuous.
+ *
+ * @param      matrix            Feature window of the block, the new rows are at the end
+ * @param      config_ptr        ei_dsp_config_mfcc_t struct pointer
+ * @param      features_written  Size of the features written by the slice
+ */
+__attribute__((unused)) void ei_dsp_cont_mfcc_cmvnw_push(ei_matrix *matrix, void *config_ptr, matrix_size_t *features_written)
+{
+#if EIDSP_CMVNW_INCREMENTAL == 1
+    ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t *)config_ptr;
+
+    const size_t matrix_size = matrix->rows * matrix->cols;
+    const size_t window_rows = matrix_size / config->num_cepstral;
+
+    if (ei_dsp_cont_mfcc_cmvnw_config != config_ptr) {
+        // only the first MFCC block keeps running sums, any other one uses the full cmvnw
+        if (ei_dsp_cont_mfcc_cmvnw_config != nullptr) {
+            return;
+        }
+        if (ei_dsp_cont_mfcc_cmvnw.reset(window_rows, config->num_cepstral) != EIDSP_OK) {
+            return;
+        }
+        ei_dsp_cont_mfcc_cmvnw_config = config_ptr;
+    }
+
+    if (features_written->rows == 0) {
+        return;
+    }
+
+    if (features_written->cols != (uint32_t)config->num_cepstral) {
+        ei_dsp_cont_mfcc_cmvnw.clear();
+        return;
+    }
+
+    // rows that were already rolled out of the window don't matter for the sums
+    size_t rows = features_written->rows < window_rows ? features_written->rows : window_rows;
+    if (ei_dsp_cont_mfcc_cmvnw.push(matrix->buffer + matrix_size - (rows * config->num_cepstral), rows) != EIDSP_OK) {
+        ei_dsp_cont_mfcc_cmvnw.clear();
+    }
+#else
+    (void)matrix;
+    (void)config_ptr;
+    (void)features_written;
+#endif
+}
+
+/**
+ * @brief      Calculates the cepstral mean and variable normalization for continuous
+ *             classification, using the running sums when they cover the feature window
+ *             and falling back to calc_cepstral_mean_and_var_normalization_mfcc otherwise.
+ *
+ * @param      matrix      Source and destination matrix
+ * @param      config_ptr  ei_dsp_config_mfcc_t struct pointer
+ */
+__attribute__((unused)) void calc_cepstral_mean_and_var_normalization_mfcc_continuous(ei_matrix *matrix, void *config_ptr)
+{
+#if EIDSP_CMVNW_INCREMENTAL == 1
+    ei_dsp_config_mfcc_t *config = (ei_dsp_config_mfcc_t *)config_ptr;
+
+    uint32_t original_matrix_size = matrix->rows * matrix->cols;
+
+    if (ei_dsp_cont_mfcc_cmvnw_config != config_ptr || !ei_dsp_cont_mfcc_cmvnw.is_ready() ||
+        original_matrix_size != ei_dsp_cont_mfcc_cmvnw.rows() * ei_dsp_cont_mfcc_cmvnw.cols()) {
+        calc_cepstral_mean_and_var_normalization_mfcc(matrix, config_ptr);
+        return;
+    }
+
+    /* Modify rows and colums ration for matrix normalization */
+    matrix->rows = original_matrix_size / config->num_cepstral;
+    matrix->cols = config->num_cepstral;
+
+    // cepstral mean and variance normalization
+    int ret = ei_dsp_cont_mfcc_cmvnw.apply(matrix, config->win_size, true, false);
+    if (ret != EIDSP_OK) {
+        ei_printf("ERR: cmvnw failed (%d)\n", ret);
+        return;
+    }
+
+    /* Reset rows and columns ratio */
+    matrix->rows = 1;
+    matrix->cols = original_matrix_size;
+#else
+    calc_cepstral_mean_and_var_normalization_mfcc(matrix, config_ptr);
+#endif
+}
+
 /**
  * @brief      Calculates the cepstral mean and variable normalization.
  *
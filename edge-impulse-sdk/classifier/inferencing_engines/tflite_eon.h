@@ -45,10 +45,78 @@
 #include "edge-impulse-sdk/classifier/inferencing_engines/tflite_helper.h"
 #include "edge-impulse-sdk/classifier/ei_run_dsp.h"
 
+#if EI_CLASSIFIER_TFLITE_EON_PERSISTENT_SESSION == 1
+#ifndef EI_CLASSIFIER_TFLITE_EON_MAX_SESSIONS
+#define EI_CLASSIFIER_TFLITE_EON_MAX_SESSIONS   4
+#endif
+
+/**
+ * Compiled graphs that stay initialized between inferences. A compiled graph keeps its
+ * state in file-level statics, so sessions are keyed on the graph's init function rather
+ * than on the (possibly stack allocated) graph config.
+ */
+typedef struct {
+    TfLiteStatus (*model_init)(void*(*alloc_fnc)(size_t, size_t));
+    TfLiteStatus (*model_reset)(void (*free)(void* ptr));
+} ei_tflite_eon_session_t;
+
+static ei_tflite_eon_session_t ei_tflite_eon_sessions[EI_CLASSIFIER_TFLITE_EON_MAX_SESSIONS] = { };
+
+static bool ei_tflite_eon_session_is_open(ei_config_tflite_eon_graph_t *graph_config) {
+    for (size_t ix = 0; ix < EI_CLASSIFIER_TFLITE_EON_MAX_SESSIONS; ix++) {
+        if (ei_tflite_eon_sessions[ix].model_init == graph_config->model_init) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool ei_tflite_eon_session_register(ei_config_tflite_eon_graph_t *graph_config) {
+    for (size_t ix = 0; ix < EI_CLASSIFIER_TFLITE_EON_MAX_SESSIONS; ix++) {
+        if (ei_tflite_eon_sessions[ix].model_init == nullptr) {
+            ei_tflite_eon_sessions[ix].model_init = graph_config->model_init;
+            ei_tflite_eon_sessions[ix].model_reset = graph_config->model_reset;
+            return true;
+        }
+    }
+    return false;
+}
+#endif // EI_CLASSIFIER_TFLITE_EON_PERSISTENT_SESSION == 1
+
+/**
+ * Release every persistent EON session (frees the tensor arenas). The next inference
+ * initializes the graph again. No-op when persistent sessions are disabled.
+ */
+__attribute__((unused)) static void ei_tflite_eon_close_sessions(void) {
+#if EI_CLASSIFIER_TFLITE_EON_PERSISTENT_SESSION == 1
+    for (size_t ix = 0; ix < EI_CLASSIFIER_TFLITE_EON_MAX_SESSIONS; ix++) {
+        if (ei_tflite_eon_sessions[ix].model_init != nullptr) {
+            ei_tflite_eon_sessions[ix].model_reset(ei_aligned_free);
+            ei_tflite_eon_sessions[ix].model_init = nullptr;
+            ei_tflite_eon_sessions[ix].model_reset = nullptr;
+        }
+    }
+#endif
+}
+
+/**
+ * Graph init time of the NN DSP blocks (run_nn_inference_from_dsp) since the last call to
+ * ei_tflite_eon_take_dsp_init_us(). Those blocks run inside the DSP step and have no result
+ * to write to, so run_classifier collects it after the step.
+ */
+static uint64_t ei_tflite_eon_dsp_init_us = 0;
+
+__attribute__((unused)) static uint64_t ei_tflite_eon_take_dsp_init_us(void) {
+    uint64_t init_us = ei_tflite_eon_dsp_init_us;
+    ei_tflite_eon_dsp_init_us = 0;
+    return init_us;
+}
+
 /**
  * Setup the TFLite runtime
  *
  * @param      ctx_start_us       Pointer to the start time
+ * @param      ctx_init_us        Time spent initializing the graph (0 if a persistent session was reused)
  * @param      input              Pointer to input tensor
  * @param      output             Pointer to output tensor
  * @param      micro_tensor_arena Pointer to the arena that will be allocated
@@ -58,6 +126,7 @@
 static EI_IMPULSE_ERROR inference_tflite_setup(
     ei_learning_block_config_tflite_graph_t *block_config,
     uint64_t *ctx_start_us,
+    uint64_t *ctx_init_us,
     TfLiteTensor* input,
     TfLiteTensor* output,
     TfLiteTensor* output_labels,
@@ -67,12 +136,23 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
     *ctx_start_us = ei_read_timer_us();
-
-    TfLiteStatus init_status = graph_config->model_init(ei_aligned_calloc);
-    if (init_status != kTfLiteOk) {
-        ei_printf("Failed to initialize the model (error code %d)\n", init_status);
-        return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+    *ctx_init_us = 0;
+
+#if EI_CLASSIFIER_TFLITE_EON_PERSISTENT_SESSION == 1
+    if (!ei_tflite_eon_session_is_open(graph_config)) {
+#endif
+        TfLiteStatus init_status = graph_config->model_init(ei_aligned_calloc);
+        if (init_status != kTfLiteOk) {
+            ei_printf("Failed to initialize the model (error code %d)\n", init_status);
+            return EI_IMPULSE_TFLITE_ARENA_ALLOC_FAILED;
+        }
+        *ctx_init_us = ei_read_timer_us() - *ctx_start_us;
+#if EI_CLASSIFIER_TFLITE_EON_PERSISTENT_SESSION == 1
+        if (!ei_tflite_eon_session_register(graph_config)) {
+            ei_printf("WARN: No free EON session slot, graph will be reset after this inference\n");
+        }
     }
+#endif
 
     TfLiteStatus status;
 
@@ -99,6 +179,19 @@ static EI_IMPULSE_ERROR inference_tflite_setup(
     return EI_IMPULSE_OK;
 }
 
+/**
+ * Counterpart of inference_tflite_setup: resets the graph unless it is kept in a
+ * persistent session.
+ */
+static TfLiteStatus inference_tflite_teardown(ei_config_tflite_eon_graph_t *graph_config) {
+#if EI_CLASSIFIER_TFLITE_EON_PERSISTENT_SESSION == 1
+    if (ei_tflite_eon_session_is_open(graph_config)) {
+        return kTfLiteOk;
+    }
+#endif
+    return graph_config->model_reset(ei_aligned_free);
+}
+
 /**
  * Run TFLite model
  *
@@ -124,12 +217,15 @@ static EI_IMPULSE_ERROR inference_tflite_run(
 
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
+    uint64_t invoke_start_us = ei_read_timer_us();
+
     if (graph_config->model_invoke() != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
     uint64_t ctx_end_us = ei_read_timer_us();
 
+    result->timing.classification_invoke_us = ctx_end_us - invoke_start_us;
     result->timing.classification_us = ctx_end_us - ctx_start_us;
     result->timing.classification = (int)(result->timing.classification_us / 1000);
 
@@ -171,12 +267,14 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
     TfLiteTensor output_scores;
     TfLiteTensor output_labels;
     uint64_t ctx_start_us = ei_read_timer_us();
+    uint64_t ctx_init_us;
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
     ei_config_tflite_eon_graph_t *graph_config = (ei_config_tflite_eon_graph_t*)block_config->graph_config;
 
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(
         block_config,
         &ctx_start_us,
+        &ctx_init_us,
         &input,
         &output,
         &output_labels,
@@ -187,6 +285,8 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         return init_res;
     }
 
+    ei_tflite_eon_dsp_init_us += ctx_init_us;
+
     auto input_res = fill_input_tensor_from_signal(signal, &input);
     if (input_res != EI_IMPULSE_OK) {
         return input_res;
@@ -202,7 +302,7 @@ EI_IMPULSE_ERROR run_nn_inference_from_dsp(
         return output_res;
     }
 
-    if (graph_config->model_reset(ei_aligned_free) != kTfLiteOk) {
+    if (inference_tflite_teardown(graph_config) != kTfLiteOk) {
         return EI_IMPULSE_TFLITE_ERROR;
     }
 
@@ -237,11 +337,13 @@ EI_IMPULSE_ERROR run_nn_inference(
     TfLiteTensor output_labels;
 
     uint64_t ctx_start_us = ei_read_timer_us();
+    uint64_t ctx_init_us;
     ei_unique_ptr_t p_tensor_arena(nullptr, ei_aligned_free);
 
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(
         block_config,
         &ctx_start_us,
+        &ctx_init_us,
         &input,
         &output,
         &output_labels,
@@ -252,6 +354,8 @@ EI_IMPULSE_ERROR run_nn_inference(
         return init_res;
     }
 
+    result->timing.classification_init_us += ctx_init_us;
+
     uint8_t* tensor_arena = static_cast<uint8_t*>(p_tensor_arena.get());
 
     size_t mtx_size = impulse->dsp_blocks_size + impulse->learning_blocks_size;
@@ -276,7 +380,7 @@ EI_IMPULSE_ERROR run_nn_inference(
         }
     }
 
-    graph_config->model_reset(ei_aligned_free);
+    inference_tflite_teardown(graph_config);
 
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
@@ -304,6 +408,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     memset(result, 0, sizeof(ei_impulse_result_t));
 
     uint64_t ctx_start_us;
+    uint64_t ctx_init_us;
     TfLiteTensor input;
     TfLiteTensor output;
     TfLiteTensor output_scores;
@@ -314,6 +419,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     EI_IMPULSE_ERROR init_res = inference_tflite_setup(
         block_config,
         &ctx_start_us,
+        &ctx_init_us,
         &input, &output,
         &output_labels,
         &output_scores,
@@ -358,6 +464,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
     }
 
     ctx_start_us = ei_read_timer_us();
+    result->timing.classification_init_us += ctx_init_us;
 
     EI_IMPULSE_ERROR run_res = inference_tflite_run(
         impulse,
@@ -370,7 +477,7 @@ EI_IMPULSE_ERROR run_nn_inference_image_quantized(
         result,
         debug);
 
-    graph_config->model_reset(ei_aligned_free);
+    inference_tflite_teardown(graph_config);
 
     if (run_res != EI_IMPULSE_OK) {
         return run_res;
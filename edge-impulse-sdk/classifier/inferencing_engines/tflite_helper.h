@@ -36,6 +36,7 @@
 #define _EI_CLASSIFIER_INFERENCING_ENGINE_TFLITE_HELPER_H_
 
 #include "edge-impulse-sdk/classifier/ei_quantize.h"
+#include "edge-impulse-sdk/dsp/dsp_engines/ei_neon_dsp.h"
 #if (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE_FULL) || (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE) || (EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TENSORRT)
 
 #if EI_CLASSIFIER_INFERENCING_ENGINE == EI_CLASSIFIER_TFLITE_FULL
@@ -87,11 +88,10 @@ EI_IMPULSE_ERROR fill_input_tensor_from_matrix(
                 break;
             }
             case kTfLiteInt8: {
-                for (size_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
-                    float val = (float)matrix->buffer[ix];
-                    input->data.int8[input_idx++] = static_cast<int8_t>(
-                        pre_cast_quantize(val, input->params.scale, input->params.zero_point, true));
-                }
+                // quantize the features straight into the tensor arena
+                ei::simd::quantize_i8(matrix->buffer, input->data.int8 + input_idx, matrix->rows * matrix->cols,
+                    input->params.scale, input->params.zero_point);
+                input_idx += matrix->rows * matrix->cols;
                 break;
             }
             case kTfLiteUInt8: {
@@ -102,5 +102,34 @@
 #define EIDSP_SIGNAL_C_FN_POINTER    0
 #endif // EIDSP_SIGNAL_C_FN_POINTER
 
+// keep KissFFT plans (twiddle factors) in a process-wide cache instead of
+// allocating a new plan for every FFT
+#ifndef EIDSP_FFT_PLAN_CACHE
+#define EIDSP_FFT_PLAN_CACHE         1
+#endif // EIDSP_FFT_PLAN_CACHE
+
+// guard the DSP caches (FFT plans, DCT bases) with a mutex, required when impulses
+// run on several threads
+#ifndef EIDSP_CACHE_THREAD_SAFE
+#if defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+#define EIDSP_CACHE_THREAD_SAFE 1
+#else
+#define EIDSP_CACHE_THREAD_SAFE 0
+#endif
+#endif // EIDSP_CACHE_THREAD_SAFE
+
+// in continuous mode, keep running sums for the MFCC normalization (cmvnw) and
+// update them per slice instead of re-summing the whole feature window
+#ifndef EIDSP_CMVNW_INCREMENTAL
+#define EIDSP_CMVNW_INCREMENTAL      1
+#endif // EIDSP_CMVNW_INCREMENTAL
+
+// use ARMv8 NEON for the vector kernels of the MFCC front-end (pre-emphasis,
+// power spectrum, filterbank, log, CMVN), see dsp_engines/ei_neon_dsp.h
+// opt-in (build with EIDSP_USE_NEON=1 on aarch64), check with tests/ei_neon_dsp_test.cpp first
+#ifndef EIDSP_USE_NEON
+#define EIDSP_USE_NEON               0
+#endif // EIDSP_USE_NEON
+
 // clang-format on
 #endif // _EIDSP_CPP_CONFIG_H_
@@ -0,0 +1,244 @@
+/*
+ * Copyright (c) 2024 EdgeImpulse Inc.
+ *
+ * Generated by Edge Impulse and licensed under the applicable Edge Impulse
+ * Terms of Service. Community and Professional Terms of Service
+ * (https://edgeimpulse.com/legal/terms-of-service) or Enterprise Terms of
+ * Service (https://edgeimpulse.com/legal/enterprise-terms-of-service),
+ * according to your product plan subscription (the “License”).
+ *
+ * This software, documentation and other associated files (collectively referred
+ * to as the “Software”) is a single SDK variation generated by the Edge Impulse
+ * platform and requires an active paid Edge Impulse subscription to use this
+ * Software for any purpose.
+ *
+ * You may NOT use this Software unless you have an active Edge Impulse subscription
+ * that meets the eligibility requirements for the applicable License, subject to
+ * your full and continued compliance with the terms and conditions of the License,
+ * including without limitation any usage restrictions under the applicable License.
+ *
+ * If you do not have an active Edge Impulse product plan subscription, or if use
+ * of this Software exceeds the usage limitations of your Edge Impulse product plan
+ * subscription, you are not permitted to use this Software and must immediately
+ * delete and erase all copies of this Software within your control or possession.
+ * Edge Impulse reserves all rights and remedies available to enforce its rights.
+ *
+ * Unless required by applicable law or agreed to in writing, the Software is
+ * distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND,
+ * either express or implied. See the License for the specific language governing
+ * permissions, disclaimers and limitations under the License.
+ */
+#ifndef __EI_NEON_DSP__H__
+#define __EI_NEON_DSP__H__
+
+#include <cstddef>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include "edge-impulse-sdk/dsp/config.hpp"
+#include "edge-impulse-sdk/dsp/numpy_types.h"
+
+#if EIDSP_USE_NEON == 1
+#include <arm_neon.h>
+#endif
+
+// Vector kernels for the MFCC front-end and the int8 input tensor. With EIDSP_USE_NEON these use ARMv8 NEON
+// (4 floats per instruction) and fall back to the scalar loop for the tail; otherwise
+// they are plain scalar loops, identical to the code they replace.
+
+namespace ei {
+
+namespace simd {
+
+/**
+ * out[i] = in[i] * scale
+ */
+static inline void int16_to_float(const int16_t *in, float *out, size_t n, float scale) {
+    size_t ix = 0;
+#if EIDSP_USE_NEON == 1
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    for (; ix + 8 <= n; ix += 8) {
+        int16x8_t v = vld1q_s16(in + ix);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+        vst1q_f32(out + ix, vmulq_f32(lo, vscale));
+        vst1q_f32(out + ix + 4, vmulq_f32(hi, vscale));
+    }
+#endif
+    for (; ix < n; ix++) {
+        out[ix] = static_cast<float>(in[ix]) * scale;
+    }
+}
+
+/**
+ * In place pre-emphasis with a shift of 1: buffer[i] -= cof * buffer[i - 1],
+ * where buffer[-1] is prev. Runs back to front so every input is read before
+ * it is overwritten.
+ */
+static inline void preemphasis(float *buffer, size_t n, float prev, float cof) {
+    if (n == 0) {
+        return;
+    }
+
+    size_t ix = n;
+#if EIDSP_USE_NEON == 1
+    const float32x4_t vcof = vdupq_n_f32(cof);
+    while (ix >= 5) {
+        ix -= 4;
+        float32x4_t now = vld1q_f32(buffer + ix);
+        float32x4_t before = vld1q_f32(buffer + ix - 1);
+        vst1q_f32(buffer + ix, vsubq_f32(now, vmulq_f32(vcof, before)));
+    }
+#endif
+    while (ix > 1) {
+        ix--;
+        buffer[ix] = buffer[ix] - (cof * buffer[ix - 1]);
+    }
+    buffer[0] = buffer[0] - (cof * prev);
+}
+
+/**
+ * Power from a complex spectrum: out[i] = scale * (r * r + i * i)
+ */
+static inline void power_from_complex(const ei::fft_complex_t *in, float *out, size_t n, float scale) {
+    size_t ix = 0;
+#if EIDSP_USE_NEON == 1
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    for (; ix + 4 <= n; ix += 4) {
+        // de-interleave 4 complex values into real and imaginary parts
+        float32x4x2_t v = vld2q_f32(reinterpret_cast<const float*>(in + ix));
+        float32x4_t power = vaddq_f32(vmulq_f32(v.val[0], v.val[0]), vmulq_f32(v.val[1], v.val[1]));
+        vst1q_f32(out + ix, vmulq_f32(vscale, power));
+    }
+#endif
+    for (; ix < n; ix++) {
+        out[ix] = scale * ((in[ix].r * in[ix].r) + (in[ix].i * in[ix].i));
+    }
+}
+
+/**
+ * sum + dot product of two float vectors. The NEON path uses four partial sums,
+ * so the result differs from the sequential sum by float rounding only.
+ */
+static inline float dot(const float *a, const float *b, size_t n, float sum = 0.0f) {
+    size_t ix = 0;
+#if EIDSP_USE_NEON == 1
+    if (n >= 4) {
+        float32x4_t acc = vmulq_f32(vld1q_f32(a), vld1q_f32(b));
+        for (ix = 4; ix + 4 <= n; ix += 4) {
+            acc = vfmaq_f32(acc, vld1q_f32(a + ix), vld1q_f32(b + ix));
+        }
+        sum += vaddvq_f32(acc);
+    }
+#endif
+    for (; ix < n; ix++) {
+        sum += a[ix] * b[ix];
+    }
+    return sum;
+}
+
+/**
+ * a[i] -= b[i]
+ */
+static inline void subtract(float *a, const float *b, size_t n) {
+    size_t ix = 0;
+#if EIDSP_USE_NEON == 1
+    for (; ix + 4 <= n; ix += 4) {
+        vst1q_f32(a + ix, vsubq_f32(vld1q_f32(a + ix), vld1q_f32(b + ix)));
+    }
+#endif
+    for (; ix < n; ix++) {
+        a[ix] = a[ix] - b[ix];
+    }
+}
+
+/**
+ * Natural log, same approximation (and same results) as numpy::log(float)
+ */
+__attribute__((always_inline)) static inline float log_f32(float a) {
+    // bit casts through memcpy, pointer casts break strict aliasing at -O2
+    int32_t g;
+    memcpy(&g, &a, sizeof(g));
+    int32_t e = (g - 0x3f2aaaab) & 0xff800000;
+    g = g - e;
+    float m;
+    memcpy(&m, &g, sizeof(m));
+    float i = (float)e * 1.19209290e-7f; // 0x1.0p-23
+    /* m in [2/3, 4/3] */
+    float f = m - 1.0f;
+    float s = f * f;
+    /* Compute log1p(f) for f in [-1/3, 1/3] */
+    float r = fmaf(0.230836749f, f, -0.279208571f);
+    float t = fmaf(0.331826031f, f, -0.498910338f);
+    r = fmaf(r, s, t);
+    r = fmaf(r, s, f);
+    r = fmaf(i, 0.693147182f, r); // log(2)
+    return r;
+}
+
+/**
+ * In place natural log of a buffer, see log_f32
+ */
+static inline void log(float *buffer, size_t n) {
+    size_t ix = 0;
+#if EIDSP_USE_NEON == 1
+    const int32x4_t offset = vdupq_n_s32(0x3f2aaaab);
+    const int32x4_t exp_mask = vdupq_n_s32((int32_t)0xff800000);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t c0 = vdupq_n_f32(0.230836749f);
+    const float32x4_t c1 = vdupq_n_f32(-0.279208571f);
+    const float32x4_t c2 = vdupq_n_f32(0.331826031f);
+    const float32x4_t c3 = vdupq_n_f32(-0.498910338f);
+    const float32x4_t ln2 = vdupq_n_f32(0.693147182f);
+    const float32x4_t exp_scale = vdupq_n_f32(1.19209290e-7f);
+
+    for (; ix + 4 <= n; ix += 4) {
+        int32x4_t g = vreinterpretq_s32_f32(vld1q_f32(buffer + ix));
+        int32x4_t e = vandq_s32(vsubq_s32(g, offset), exp_mask);
+        float32x4_t m = vreinterpretq_f32_s32(vsubq_s32(g, e));
+        float32x4_t i = vmulq_f32(vcvtq_f32_s32(e), exp_scale);
+        float32x4_t f = vsubq_f32(m, one);
+        float32x4_t s = vmulq_f32(f, f);
+        // vfmaq_f32(a, b, c) = a + b * c, fused like fmaf
+        float32x4_t r = vfmaq_f32(c1, c0, f);
+        float32x4_t t = vfmaq_f32(c3, c2, f);
+        r = vfmaq_f32(t, r, s);
+        r = vfmaq_f32(f, r, s);
+        r = vfmaq_f32(r, i, ln2);
+        vst1q_f32(buffer + ix, r);
+    }
+#endif
+    for (; ix < n; ix++) {
+        buffer[ix] = log_f32(buffer[ix]);
+    }
+}
+
+/**
+ * Quantize to int8: out[i] = clamp(round(in[i] / scale) + zero_point, -128, 127),
+ * same results as pre_cast_quantize(in[i], scale, zero_point, true)
+ */
+static inline void quantize_i8(const float *in, int8_t *out, size_t n, float scale, int32_t zero_point) {
+    size_t ix = 0;
+#if EIDSP_USE_NEON == 1
+    const float32x4_t vscale = vdupq_n_f32(scale);
+    const int32x4_t vzero_point = vdupq_n_s32(zero_point);
+    for (; ix + 8 <= n; ix += 8) {
+        // vrndaq_f32 rounds half away from zero, like round()
+        int32x4_t lo = vcvtq_s32_f32(vrndaq_f32(vdivq_f32(vld1q_f32(in + ix), vscale)));
+        int32x4_t hi = vcvtq_s32_f32(vrndaq_f32(vdivq_f32(vld1q_f32(in + ix + 4), vscale)));
+        // saturating narrows do the clamp
+        int16x8_t q = vcombine_s16(vqmovn_s32(vaddq_s32(lo, vzero_point)), vqmovn_s32(vaddq_s32(hi, vzero_point)));
+        vst1_s8(out + ix, vqmovn_s16(q));
+    }
+#endif
+    for (; ix < n; ix++) {
+        int32_t q = static_cast<int32_t>(roundf(in[ix] / scale)) + zero_point;
+        out[ix] = static_cast<int8_t>(q < -128 ? -128 : (q > 127 ? 127 : q));
+    }
+}
+
+} // namespace simd
+
+} // namespace ei
+
+#endif  //!__EI_NEON_DSP__H__
@@ -0,0 +1,139 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EIDSP_DCT_BASIS_CACHE_H_
+#define _EIDSP_DCT_BASIS_CACHE_H_
+
+#include <stddef.h>
+#include <math.h>
+#include "config.hpp"
+#include "numpy_types.h"
+#include "ei_cache_lock.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+namespace ei {
+namespace dct {
+
+/**
+ * Process-wide cache of DCT-II basis matrices, keyed by (N, K, normalization).
+ *
+ * The basis is stored transposed (N rows of K coefficients) so that a truncated
+ * DCT of a frame is a small matrix product whose inner loop runs over the K
+ * outputs. Bases are read-only once built and shared by all callers; they live
+ * until clear() is called.
+ */
+class dct2_basis_cache {
+public:
+    /**
+     * Get the basis for a DCT-II of length n that keeps the first k coefficients
+     * @param n Input length
+     * @param k Number of output coefficients (k <= n)
+     * @param normalization DCT_NORMALIZATION_NONE or DCT_NORMALIZATION_ORTHO
+     * @returns n * k floats, basis[i * k + j] = weight of input i in output j, or nullptr if out of memory
+     */
+    static const float *get(size_t n, size_t k, DCT_NORMALIZATION_MODE normalization) {
+        ei_cache_lock_t lock(mutex());
+
+        for (entry_t *e = head(); e != nullptr; e = e->next) {
+            if (e->n == n && e->k == k && e->normalization == normalization) {
+                return e->basis;
+            }
+        }
+
+        entry_t *e = (entry_t*)ei_calloc(1, sizeof(entry_t));
+        if (!e) {
+            return nullptr;
+        }
+        e->basis = (float*)ei_calloc(n * k, sizeof(float));
+        if (!e->basis) {
+            ei_free(e);
+            return nullptr;
+        }
+        e->n = n;
+        e->k = k;
+        e->normalization = normalization;
+
+        // same definition as scipy.fftpack.dct(type=2): y[j] = 2 * sum(x[i] * cos(pi * j * (2i + 1) / 2n))
+        for (size_t j = 0; j < k; j++) {
+            double scale = 2.0;
+            if (normalization == DCT_NORMALIZATION_ORTHO) {
+                scale *= (j == 0) ? sqrt(1.0 / (4.0 * n)) : sqrt(1.0 / (2.0 * n));
+            }
+            for (size_t i = 0; i < n; i++) {
+                e->basis[i * k + j] = (float)(scale * cos(M_PI * j * (2.0 * i + 1.0) / (2.0 * n)));
+            }
+        }
+
+        e->next = head();
+        head() = e;
+        return e->basis;
+    }
+
+    /**
+     * Free all cached bases. Pointers returned by get() become invalid.
+     */
+    static void clear() {
+        ei_cache_lock_t lock(mutex());
+        while (head()) {
+            entry_t *e = head();
+            head() = e->next;
+            ei_free(e->basis);
+            ei_free(e);
+        }
+    }
+
+private:
+    typedef struct entry {
+        float *basis;
+        size_t n;
+        size_t k;
+        DCT_NORMALIZATION_MODE normalization;
+        struct entry *next;
+    } entry_t;
+
+    static entry_t *&head() {
+        static entry_t *list = nullptr;
+        return list;
+    }
+
+    static ei_cache_mutex_t &mutex() {
+        static ei_cache_mutex_t m;
+        return m;
+    }
+};
+
+} // namespace dct
+} // namespace ei
+
+#endif // _EIDSP_DCT_BASIS_CACHE_H_
@@ -0,0 +1,173 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EIDSP_FFT_PLAN_CACHE_H_
+#define _EIDSP_FFT_PLAN_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.hpp"
+#include "ei_cache_lock.h"
+#include "kissfft/kiss_fftr.h"
+#include "edge-impulse-sdk/porting/ei_classifier_porting.h"
+
+namespace ei {
+namespace fft {
+
+/**
+ * Process-wide cache of KissFFT real FFT plans, keyed by (n_fft, inverse).
+ *
+ * kiss_fftr_alloc() computes all twiddle factors with cos/sin and mallocs the plan,
+ * which used to happen on every call to software_rfft(). Plans are now created once
+ * and handed out with acquire() / release(). A plan carries its own scratch buffer,
+ * so it is checked out exclusively; when several threads need the same size at the
+ * same time an extra plan is created for that key and kept for later reuse.
+ */
+class kissfft_plan_cache {
+public:
+    /**
+     * Get a plan for the given size and direction, creating it on a miss
+     * @param n_fft FFT length (must be even)
+     * @param inverse True for an inverse (c2r) plan
+     * @returns The plan, or nullptr if out of memory
+     */
+    static kiss_fftr_cfg acquire(size_t n_fft, bool inverse) {
+        {
+            ei_cache_lock_t lock(mutex());
+            for (entry_t *e = head(); e != nullptr; e = e->next) {
+                if (!e->in_use && e->n_fft == n_fft && e->inverse == inverse) {
+                    e->in_use = true;
+                    return e->cfg;
+                }
+            }
+        }
+
+        // build outside of the lock, twiddle computation is the expensive part
+        entry_t *e = (entry_t*)ei_calloc(1, sizeof(entry_t));
+        if (!e) {
+            return nullptr;
+        }
+        e->cfg = kiss_fftr_alloc(static_cast<int>(n_fft), inverse ? 1 : 0, NULL, NULL);
+        if (!e->cfg) {
+            ei_free(e);
+            return nullptr;
+        }
+        e->n_fft = n_fft;
+        e->inverse = inverse;
+        e->in_use = true;
+
+        ei_cache_lock_t lock(mutex());
+        e->next = head();
+        head() = e;
+        return e->cfg;
+    }
+
+    /**
+     * Return a plan obtained from acquire()
+     */
+    static void release(kiss_fftr_cfg cfg) {
+        ei_cache_lock_t lock(mutex());
+        for (entry_t *e = head(); e != nullptr; e = e->next) {
+            if (e->cfg == cfg) {
+                e->in_use = false;
+                return;
+            }
+        }
+    }
+
+    /**
+     * Free every plan that is not checked out
+     */
+    static void clear() {
+        ei_cache_lock_t lock(mutex());
+        entry_t **link = &head();
+        while (*link) {
+            entry_t *e = *link;
+            if (e->in_use) {
+                link = &e->next;
+                continue;
+            }
+            *link = e->next;
+            kiss_fftr_free(e->cfg);
+            ei_free(e);
+        }
+    }
+
+private:
+    typedef struct entry {
+        kiss_fftr_cfg cfg;
+        size_t n_fft;
+        bool inverse;
+        bool in_use;
+        struct entry *next;
+    } entry_t;
+
+    static entry_t *&head() {
+        static entry_t *list = nullptr;
+        return list;
+    }
+
+    static ei_cache_mutex_t &mutex() {
+        static ei_cache_mutex_t m;
+        return m;
+    }
+};
+
+/**
+ * Scoped checkout of a cached plan
+ */
+class kissfft_plan {
+public:
+    kissfft_plan(size_t n_fft, bool inverse)
+        : cfg(kissfft_plan_cache::acquire(n_fft, inverse)) { }
+
+    ~kissfft_plan() {
+        if (cfg) {
+            kissfft_plan_cache::release(cfg);
+        }
+    }
+
+    kissfft_plan(const kissfft_plan&) = delete;
+    kissfft_plan& operator=(const kissfft_plan&) = delete;
+
+    kiss_fftr_cfg get() const { return cfg; }
+
+private:
+    kiss_fftr_cfg cfg;
+};
+
+} // namespace fft
+} // namespace ei
+
+#endif // _EIDSP_FFT_PLAN_CACHE_H_
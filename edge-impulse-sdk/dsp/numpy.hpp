@@ -61,6 +61,8 @@
 #include "ei_utils.h"
 #include "dct/fast-dct-fft.h"
 #include "kissfft/kiss_fftr.h"
+#include "ei_fft_plan_cache.h"
+#include "ei_dct_basis_cache.h"
 #include "edge-impulse-sdk/porting/ei_logging.h"
 
 #if __has_include("model-parameters/model_metadata.h")
@@ -80,6 +82,9 @@
 #include "edge-impulse-sdk/dsp/dsp_engines/ei_no_hw_dsp.h"
 #endif
 
+// vector kernels (NEON or scalar), independent of the FFT engine above
+#include "edge-impulse-sdk/dsp/dsp_engines/ei_neon_dsp.h"
+
 // More decisions on kissfft
 #ifndef EIDSP_INCLUDE_KISSFFT
 
@@ -117,6 +122,41 @@ static constexpr float quantized_values_one_zero[] = { (0.0f / 1.0f), (1.0f / 10
     1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
 // clang-format on
 
+/**
+ * Scratch space for numpy::power_spectrum(): the zero padded FFT input (n_fft floats)
+ * and the complex FFT output (n_fft / 2 + 1 values). Allocate one per FFT size and
+ * reuse it for every frame, so the per-frame path doesn't allocate.
+ */
+class fft_workspace {
+public:
+    explicit fft_workspace(size_t n_fft)
+        : n_fft(n_fft)
+    {
+        input = (float*)ei_dsp_calloc(n_fft * sizeof(float), 1);
+        output = (fft_complex_t*)ei_dsp_calloc((n_fft / 2 + 1) * sizeof(fft_complex_t), 1);
+    }
+
+    fft_workspace(const fft_workspace&) = delete;
+    fft_workspace &operator=(const fft_workspace&) = delete;
+
+    ~fft_workspace() {
+        if (input) {
+            ei_dsp_free(input, n_fft * sizeof(float));
+        }
+        if (output) {
+            ei_dsp_free(output, (n_fft / 2 + 1) * sizeof(fft_complex_t));
+        }
+    }
+
+    bool is_valid() const {
+        return input && output;
+    }
+
+    size_t n_fft;
+    float *input;
+    fft_complex_t *output;
+};
+
 class numpy {
 public:
 
@@ -642,6 +682,48 @@ public:
         return EIDSP_OK;
     }
 
+    /**
+     * Truncated Discrete Cosine Transform of type 2 on every row of a matrix.
+     * Only the first output->cols coefficients are computed, as a product with a
+     * cached basis; numerically equivalent to dct2() followed by dropping the
+     * trailing columns, without any per-row allocation.
+     * @param input Input matrix (rows x N)
+     * @param output Output matrix (rows x K), K <= N, must not alias input
+     * @returns EIDSP_OK if OK
+     */
+    static int dct2(const matrix_t *input, matrix_t *output, DCT_NORMALIZATION_MODE normalization = DCT_NORMALIZATION_NONE) {
+        const size_t n = input->cols;
+        const size_t k = output->cols;
+
+        if (input->rows != output->rows || k > n) {
+            EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+        }
+        if (n == 0 || k == 0) {
+            return EIDSP_OK;
+        }
+
+        const float *basis = dct::dct2_basis_cache::get(n, k, normalization);
+        if (!basis) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        for (size_t row = 0; row < input->rows; row++) {
+            const float *x = input->buffer + (row * n);
+            float *y = output->buffer + (row * k);
+
+            memset(y, 0, k * sizeof(float));
+            for (size_t i = 0; i < n; i++) {
+                const float xi = x[i];
+                const float *b = basis + (i * k);
+                for (size_t j = 0; j < k; j++) {
+                    y[j] += xi * b[j];
+                }
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
     /**
      * Quantize a float value between zero and one
      * @param value Float value
@@ -1344,6 +1426,25 @@ public:
      * @returns 0 if OK
      */
     static int rfft(const float *src, size_t src_size, fft_complex_t *output, size_t output_size, size_t n_fft) {
+        // Unfortunately, arm fft (at least) modifies the input buffer AND does not work in place
+        // So we have to copy the input to a new buffer
+        EI_DSP_MATRIX(fft_input, 1, n_fft);
+        if (!fft_input.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        return rfft(src, src_size, output, output_size, n_fft, fft_input.buffer);
+    }
+
+    /**
+     * Same as rfft() with a complex output, but copies (and zero pads) the source
+     * into a caller-provided buffer of n_fft floats instead of allocating one.
+     * @param fft_input Scratch buffer of n_fft floats, contents are destroyed
+     * @returns 0 if OK
+     */
+    static int rfft(const float *src, size_t src_size, fft_complex_t *output, size_t output_size, size_t n_fft,
+        float *fft_input)
+    {
         size_t n_fft_out_features = (n_fft / 2) + 1;
         if (output_size != n_fft_out_features) {
             EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
@@ -1354,23 +1455,15 @@ public:
             src_size = n_fft;
         }
 
-        // Unfortunately, arm fft (at least) modifies the input buffer AND does not work in place
-        // So we have to copy the input to a new buffer
-        EI_DSP_MATRIX(fft_input, 1, n_fft);
-        if (!fft_input.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
-
-        // If the buffer wasn't assigned to source above, let's copy and pad
         // copy from src to fft_input
-        memcpy(fft_input.buffer, src, src_size * sizeof(float));
+        memcpy(fft_input, src, src_size * sizeof(float));
         // pad to the rigth with zeros
-        memset(fft_input.buffer + src_size, 0, (n_fft - src_size) * sizeof(float));
+        memset(fft_input + src_size, 0, (n_fft - src_size) * sizeof(float));
 
-        auto res = ei::fft::hw_r2c_fft(fft_input.buffer, output, n_fft);
+        auto res = ei::fft::hw_r2c_fft(fft_input, output, n_fft);
         if (handle_fft_hw_failure(res, n_fft)) {
             // fallback to software
-            return software_rfft(fft_input.buffer, output, n_fft, n_fft_out_features);
+            return software_rfft(fft_input, output, n_fft, n_fft_out_features);
         }
 
         return EIDSP_OK;
@@ -1610,9 +1703,7 @@ public:
      */
     static int log(matrix_t *matrix)
     {
-        for (uint32_t ix = 0; ix < matrix->rows * matrix->cols; ix++) {
-            matrix->buffer[ix] = numpy::log(matrix->buffer[ix]);
-        }
+        simd::log(matrix->buffer, matrix->rows * matrix->cols);
 
         return EIDSP_OK;
     }
@@ -1741,7 +1832,18 @@ public:
 
     static int software_rfft(float *fft_input, fft_complex_t *output, size_t n_fft, size_t n_fft_out_features)
     {
-    #if EIDSP_INCLUDE_KISSFFT || !defined(EIDSP_INCLUDE_KISSFFT)
+    #if (EIDSP_INCLUDE_KISSFFT || !defined(EIDSP_INCLUDE_KISSFFT)) && EIDSP_FFT_PLAN_CACHE == 1
+        // reuse the fftr context for this size
+        fft::kissfft_plan plan(n_fft, false);
+        if (!plan.get()) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        // execute the rfft operation
+        kiss_fftr(plan.get(), fft_input, (kiss_fft_cpx*)output);
+
+        return EIDSP_OK;
+    #elif EIDSP_INCLUDE_KISSFFT || !defined(EIDSP_INCLUDE_KISSFFT)
         // create fftr context
         size_t kiss_fftr_mem_length;
 
@@ -2046,20 +2148,50 @@ public:
         float *out_buffer,
         size_t out_buffer_size,
         uint16_t fft_points)
+    {
+        fft_workspace workspace(fft_points);
+        if (!workspace.is_valid()) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        return power_spectrum(frame, frame_size, out_buffer, out_buffer_size, fft_points, &workspace);
+    }
+
+    /**
+     * Power spectrum of a frame, |X|^2 / fft_points computed straight from the
+     * complex FFT output (no magnitude / sqrt round trip), using a caller-provided
+     * workspace so nothing is allocated per frame.
+     * @param frame Row of a frame
+     * @param frame_size Size of the frame
+     * @param out_buffer Out buffer, size should be fft_points / 2 + 1
+     * @param out_buffer_size Buffer size
+     * @param fft_points (int): The length of FFT. If fft_length is greater than frame_len, the frames will be zero-padded.
+     * @param workspace Scratch space created for fft_points
+     * @returns EIDSP_OK if OK
+     */
+    static int power_spectrum(
+        float *frame,
+        size_t frame_size,
+        float *out_buffer,
+        size_t out_buffer_size,
+        uint16_t fft_points,
+        fft_workspace *workspace)
     {
         if (out_buffer_size != static_cast<size_t>(fft_points / 2 + 1)) {
             EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
         }
 
-        int r = numpy::rfft(frame, frame_size, out_buffer, out_buffer_size, fft_points);
+        if (workspace->n_fft != fft_points) {
+            EIDSP_ERR(EIDSP_BUFFER_SIZE_MISMATCH);
+        }
+
+        int r = numpy::rfft(frame, frame_size, workspace->output, out_buffer_size, fft_points, workspace->input);
         if (r != EIDSP_OK) {
             return r;
         }
 
-        for (size_t ix = 0; ix < out_buffer_size; ix++) {
-            out_buffer[ix] = (1.0 / static_cast<float>(fft_points)) *
-                (out_buffer[ix] * out_buffer[ix]);
-        }
+        simd::power_from_complex(workspace->output, out_buffer, out_buffer_size,
+            1.0f / static_cast<float>(fft_points));
 
         return EIDSP_OK;
     }
@@ -2077,6 +2209,10 @@ public:
         float saved_point = 0;
         bool do_saved_point = false;
         size_t fft_out_size = fft_points / 2 + 1;
+        fft_workspace workspace(fft_points);
+        if (!workspace.is_valid()) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
         float *fft_out;
         const size_t size = fft_out_size * sizeof(float);
         ei_unique_ptr_t p_fft_out(nullptr, [size](void* ptr){ei::ei_dsp_free_func(ptr, size);});
@@ -2104,7 +2240,8 @@ public:
                 n_input_points,
                 fft_out,
                 fft_points / 2 + 1,
-                fft_points));
+                fft_points,
+                &workspace));
             int j = 0;
             // keep the max of the last frame and everything before
             for (size_t i = start_bin; i < stop_bin; i++) {
@@ -449,31 +449,25 @@ namespace processing {
             EIDSP_ERR(ret);
         }
 
-        fft_complex_t *fft_output = (fft_complex_t*)ei_dsp_calloc((n_fft / 2 + 1) * sizeof(fft_complex_t), 1);
-        ret = numpy::rfft(welch_matrix.buffer, welch_matrix.cols, fft_output, n_fft / 2 + 1, n_fft);
+        fft_workspace workspace(n_fft);
+        if (!workspace.is_valid()) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        ret = numpy::rfft(welch_matrix.buffer, welch_matrix.cols, workspace.output, n_fft / 2 + 1, n_fft,
+            workspace.input);
         if (ret != EIDSP_OK) {
-            ei_dsp_free(fft_output, (n_fft / 2 + 1) * sizeof(fft_complex_t));
             EIDSP_ERR(ret);
         }
 
         // conjugate and then multiply with itself and scale
-        for (uint16_t ix = 0; ix < n_fft / 2 + 1; ix++) {
-            fft_output[ix].r = (fft_output[ix].r * fft_output[ix].r) +
-                (abs(fft_output[ix].i * fft_output[ix].i));
-            fft_output[ix].i = 0.0f;
+        simd::power_from_complex(workspace.output, out_fft_matrix->buffer, n_fft / 2 + 1, scale);
 
-            fft_output[ix].r *= scale;
-
-            if (ix != n_fft / 2) {
-                fft_output[ix].r *= 2;
-            }
-
-            // then multiply by itself...
-            out_fft_matrix->buffer[ix] = fft_output[ix].r;
+        // one-sided spectrum, double everything but the Nyquist bin
+        for (uint16_t ix = 0; ix < n_fft / 2; ix++) {
+            out_fft_matrix->buffer[ix] *= 2;
         }
 
-        ei_dsp_free(fft_output, (n_fft / 2 + 1) * sizeof(fft_complex_t));
-
         return EIDSP_OK;
     }
 
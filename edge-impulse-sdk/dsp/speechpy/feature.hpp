@@ -36,6 +36,7 @@
 #include "../ei_utils.h"
 #include "functions.hpp"
 #include "processing.hpp"
+#include "mel_filterbank_cache.hpp"
 #include "../memory.hpp"
 #include "../returntypes.hpp"
 #include "../ei_vector.h"
@@ -267,53 +268,22 @@ public:
         }
 
         const size_t power_spectrum_frame_size = (fft_length / 2 + 1);
-        // Computing the Mel filterbank
-        // converting the upper and lower frequencies to Mels.
-        // num_filter + 2 is because for num_filter filterbanks we need
-        // num_filter+2 point.
-        float *mels;
-        const int MELS_SIZE = num_filters + 2;
-        const size_t mem_size = MELS_SIZE * sizeof(float);
-        mels = (float*)ei_dsp_calloc(MELS_SIZE, sizeof(float));
-        EI_ERR_AND_RETURN_ON_NULL(mels, EIDSP_OUT_OF_MEM);
-        ei_unique_ptr_t __ptr__(mels,[mem_size](void* ptr){ei::ei_dsp_free_func(ptr, mem_size);});
-        uint16_t* bins = reinterpret_cast<uint16_t*>(mels); // alias the mels array so we can reuse the space
-
-        numpy::linspace(
-            functions::frequency_to_mel(static_cast<float>(low_frequency)),
-            functions::frequency_to_mel(static_cast<float>(high_frequency)),
-            num_filters + 2,
-            mels);
-
-        uint16_t max_bin = version >= 4 ? fft_length : power_spectrum_frame_size; // preserve a bug in v<4
-        // go to -1 size b/c special handling, see after
-        for (uint16_t ix = 0; ix < MELS_SIZE-1; ix++) {
-            mels[ix] = functions::mel_to_frequency(mels[ix]);
-            if (mels[ix] < low_frequency) {
-                mels[ix] = low_frequency;
-            }
-            if (mels[ix] > high_frequency) {
-                mels[ix] = high_frequency;
-            }
-            bins[ix] = get_fft_bin_from_hertz(max_bin, mels[ix], sampling_frequency);
-        }
 
-        // here is a really annoying bug in Speechpy which calculates the frequency index wrong for the last bucket
-        // the last 'hertz' value is not 8,000 (with sampling rate 16,000) but 7,999.999999
-        // thus calculating the bucket to 64, not 65.
-        // we're adjusting this here a tiny bit to ensure we have the same result
-        mels[MELS_SIZE-1] = functions::mel_to_frequency(mels[MELS_SIZE-1]);
-        if (mels[MELS_SIZE-1] > high_frequency) {
-            mels[MELS_SIZE-1] = high_frequency;
-        }
-        mels[MELS_SIZE-1] -= 0.001;
-        bins[MELS_SIZE-1] = get_fft_bin_from_hertz(max_bin, mels[MELS_SIZE-1], sampling_frequency);
+        // the Mel filterbank only depends on the configuration, so it's built once and cached
+        const mel_filterbank_t *filterbank = mel_filterbank_cache::get(
+            sampling_frequency, num_filters, fft_length, low_frequency, high_frequency, version);
+        EI_ERR_AND_RETURN_ON_NULL(filterbank, EIDSP_OUT_OF_MEM);
 
         EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
         if (!power_spectrum_frame.buffer) {
             EIDSP_ERR(EIDSP_OUT_OF_MEM);
         }
 
+        fft_workspace workspace(fft_length);
+        if (!workspace.is_valid()) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
         // get signal data from the audio file
         EI_DSP_MATRIX(signal_frame, 1, stack_frame_info.frame_length);
 
@@ -340,7 +310,8 @@ public:
                 stack_frame_info.frame_length,
                 power_spectrum_frame.buffer,
                 power_spectrum_frame_size,
-                fft_length
+                fft_length,
+                &workspace
             );
 
             if (ret != 0) {
@@ -356,34 +327,8 @@ public:
                 out_energies->buffer[ix] = energy;
             }
 
-            auto row_ptr = out_features->get_row_ptr(ix);
-            for (size_t i = 0; i < num_filters; i++) {
-                size_t left = bins[i];
-                size_t middle = bins[i+1];
-                size_t right = bins[i+2];
-
-                assert(right < power_spectrum_frame_size);
-                // now we have weights and locations to move from fft to mel sgram
-                // both left and right become zero weights, so skip them
-
-                // middle always has weight of 1.0
-                // since we skip left and right, if left = middle we need to handle that
-                row_ptr[i] = power_spectrum_frame.buffer[middle];
-
-                for (size_t bin = left+1; bin < right; bin++) {
-                    if (bin < middle) {
-                        row_ptr[i] +=
-                            ((static_cast<float>(bin) - left) / (middle - left)) * // weight *
-                            power_spectrum_frame.buffer[bin];
-                    }
-                    // intentionally skip middle, handled above
-                    if (bin > middle) {
-                        row_ptr[i] +=
-                            ((right - static_cast<float>(bin)) / (right - middle)) * // weight *
-                            power_spectrum_frame.buffer[bin];
-                    }
-                }
-            }
+            // now we have weights and locations to move from fft to mel sgram
+            mel_filterbank_cache::apply(filterbank, power_spectrum_frame.buffer, out_features->get_row_ptr(ix));
 
             if (ret != 0) {
                 EIDSP_ERR(ret);
@@ -484,14 +429,19 @@ public:
         if (ret != 0) {
             EIDSP_ERR(ret);
         }
-        for (size_t ix = 0; ix < stack_frame_info.frame_ixs.size(); ix++) {
-            size_t power_spectrum_frame_size = (fft_length / 2 + 1);
+        size_t power_spectrum_frame_size = (fft_length / 2 + 1);
 
-            EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
-            if (!power_spectrum_frame.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
-            }
+        EI_DSP_MATRIX(power_spectrum_frame, 1, power_spectrum_frame_size);
+        if (!power_spectrum_frame.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        fft_workspace workspace(fft_length);
+        if (!workspace.is_valid()) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
 
+        for (size_t ix = 0; ix < stack_frame_info.frame_ixs.size(); ix++) {
             // get signal data from the audio file
             EI_DSP_MATRIX(signal_frame, 1, stack_frame_info.frame_length);
 
@@ -517,7 +467,8 @@ public:
                 stack_frame_info.frame_length,
                 power_spectrum_frame.buffer,
                 power_spectrum_frame_size,
-                fft_length
+                fft_length,
+                &workspace
             );
 
             if (ret != 0) {
@@ -602,6 +553,11 @@ public:
             *(out_features->buffer + i) = 0;
         }
 
+        fft_workspace workspace(fft_length);
+        if (!workspace.is_valid()) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
         for (size_t ix = 0; ix < stack_frame_info.frame_ixs.size(); ix++) {
             // get signal data from the audio file
             EI_DSP_MATRIX(signal_frame, 1, stack_frame_info.frame_length);
@@ -647,7 +603,8 @@ public:
                 stack_frame_info.frame_length,
                 out_features->buffer + (ix * coefficients),
                 coefficients,
-                fft_length
+                fft_length,
+                &workspace
             );
 
             if (ret != 0) {
@@ -762,23 +719,16 @@ public:
             EIDSP_ERR(ret);
         }
 
-        // now do DST type 2
-        ret = numpy::dct2(&features_matrix, DCT_NORMALIZATION_ORTHO);
+        // now do DCT type 2, only for the cepstral coefficients we keep
+        ret = numpy::dct2(&features_matrix, out_features, DCT_NORMALIZATION_ORTHO);
         if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
 
         // replace first cepstral coefficient with log of frame energy for DC elimination
         if (dc_elimination) {
-            for (size_t row = 0; row < features_matrix.rows; row++) {
-                features_matrix.buffer[row * features_matrix.cols] = numpy::log(energy_matrix.buffer[row]);
-            }
-        }
-
-        // copy to the output...
-        for (size_t row = 0; row < features_matrix.rows; row++) {
-            for(int i = 0; i < num_cepstral; i++) {
-                *(out_features->buffer + (num_cepstral * row) + i) = *(features_matrix.buffer + (features_matrix.cols * row) + i);
+            for (size_t row = 0; row < out_features->rows; row++) {
+                out_features->buffer[row * num_cepstral] = numpy::log(energy_matrix.buffer[row]);
             }
         }
 
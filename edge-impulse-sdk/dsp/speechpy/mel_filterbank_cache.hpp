@@ -0,0 +1,294 @@
+/* The Clear BSD License
+ *
+ * Copyright (c) 2025 EdgeImpulse Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted (subject to the limitations in the disclaimer
+ * below) provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ *
+ *   * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ *
+ *   * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from this
+ *   software without specific prior written permission.
+ *
+ * NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE GRANTED BY
+ * THIS LICENSE. THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND
+ * CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _EIDSP_SPEECHPY_MEL_FILTERBANK_CACHE_H_
+#define _EIDSP_SPEECHPY_MEL_FILTERBANK_CACHE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include "functions.hpp"
+#include "../ei_cache_lock.h"
+#include "../../porting/ei_classifier_porting.h"
+
+namespace ei {
+namespace speechpy {
+
+/**
+ * One triangular Mel filter in sparse form: the weights for the FFT bins
+ * [start, start + count) live at weights[offset]. The peak bin (middle) has
+ * an implicit weight of 1.0 and is stored as 0 in the weights so that the
+ * filter stays one contiguous run of bins and, without NEON, is accumulated in
+ * the same order as the dense implementation.
+ */
+typedef struct {
+    uint16_t start;
+    uint16_t count;
+    uint16_t middle;
+    uint32_t offset;
+} mel_filter_t;
+
+typedef struct {
+    const mel_filter_t *filters;
+    const float *weights;
+    uint16_t num_filters;
+    size_t power_spectrum_frame_size;
+} mel_filterbank_t;
+
+/**
+ * Process-wide cache of sparse Mel filterbanks as used by feature::mfe(),
+ * keyed on (sampling_frequency, num_filters, fft_length, low_frequency,
+ * high_frequency, version). Filterbanks are read-only once built and shared by
+ * all callers; they live until clear() is called.
+ */
+class mel_filterbank_cache {
+public:
+    /**
+     * Get the filterbank for a configuration, building it on first use
+     * @param sampling_frequency Sampling frequency in Hz
+     * @param num_filters Number of filters
+     * @param fft_length Number of FFT points
+     * @param low_frequency Lowest band edge in Hz (already defaulted by the caller)
+     * @param high_frequency Highest band edge in Hz (already defaulted by the caller)
+     * @param version Implementation version of the MFE block
+     * @returns The filterbank, or nullptr if out of memory
+     */
+    static const mel_filterbank_t *get(
+        uint32_t sampling_frequency, uint16_t num_filters, uint16_t fft_length,
+        uint32_t low_frequency, uint32_t high_frequency, uint16_t version)
+    {
+        ei_cache_lock_t lock(mutex());
+
+        // versions before 4 share the same bin computation
+        const bool v4 = version >= 4;
+
+        for (entry_t *e = head(); e != nullptr; e = e->next) {
+            if (e->sampling_frequency == sampling_frequency && e->num_filters == num_filters &&
+                e->fft_length == fft_length && e->low_frequency == low_frequency &&
+                e->high_frequency == high_frequency && e->v4 == v4) {
+                return &e->filterbank;
+            }
+        }
+
+        entry_t *e = build(sampling_frequency, num_filters, fft_length, low_frequency, high_frequency, v4);
+        if (!e) {
+            return nullptr;
+        }
+
+        e->next = head();
+        head() = e;
+        return &e->filterbank;
+    }
+
+    /**
+     * Apply a filterbank to one power spectrum frame
+     * @param filterbank Filterbank from get()
+     * @param power_spectrum power_spectrum_frame_size bins
+     * @param out num_filters outputs
+     */
+    static inline void apply(const mel_filterbank_t *filterbank, const float *power_spectrum, float *out) {
+        const mel_filter_t *filter = filterbank->filters;
+
+        for (uint16_t i = 0; i < filterbank->num_filters; i++, filter++) {
+            const float *w = filterbank->weights + filter->offset;
+            const float *p = power_spectrum + filter->start;
+
+            out[i] = simd::dot(w, p, filter->count, power_spectrum[filter->middle]);
+        }
+    }
+
+    /**
+     * Free all cached filterbanks. Pointers returned by get() become invalid.
+     */
+    static void clear() {
+        ei_cache_lock_t lock(mutex());
+        while (head()) {
+            entry_t *e = head();
+            head() = e->next;
+            free_entry(e);
+        }
+    }
+
+private:
+    typedef struct entry {
+        mel_filterbank_t filterbank;
+        mel_filter_t *filters;
+        float *weights;
+        uint32_t sampling_frequency;
+        uint16_t num_filters;
+        uint16_t fft_length;
+        uint32_t low_frequency;
+        uint32_t high_frequency;
+        bool v4;
+        struct entry *next;
+    } entry_t;
+
+    static entry_t *build(
+        uint32_t sampling_frequency, uint16_t num_filters, uint16_t fft_length,
+        uint32_t low_frequency, uint32_t high_frequency, bool v4)
+    {
+        const size_t power_spectrum_frame_size = (fft_length / 2 + 1);
+        const int MELS_SIZE = num_filters + 2;
+
+        float *mels = (float*)ei_calloc(MELS_SIZE, sizeof(float));
+        uint16_t *bins = (uint16_t*)ei_calloc(MELS_SIZE, sizeof(uint16_t));
+        if (!mels || !bins) {
+            ei_free(mels);
+            ei_free(bins);
+            return nullptr;
+        }
+
+        // Computing the Mel filterbank
+        // converting the upper and lower frequencies to Mels.
+        // num_filter + 2 is because for num_filter filterbanks we need
+        // num_filter+2 point.
+        numpy::linspace(
+            functions::frequency_to_mel(static_cast<float>(low_frequency)),
+            functions::frequency_to_mel(static_cast<float>(high_frequency)),
+            MELS_SIZE,
+            mels);
+
+        uint16_t max_bin = v4 ? fft_length : power_spectrum_frame_size; // preserve a bug in v<4
+        // go to -1 size b/c special handling, see after
+        for (int ix = 0; ix < MELS_SIZE - 1; ix++) {
+            mels[ix] = functions::mel_to_frequency(mels[ix]);
+            if (mels[ix] < low_frequency) {
+                mels[ix] = low_frequency;
+            }
+            if (mels[ix] > high_frequency) {
+                mels[ix] = high_frequency;
+            }
+            bins[ix] = bin_from_hertz(max_bin, mels[ix], sampling_frequency);
+        }
+
+        // here is a really annoying bug in Speechpy which calculates the frequency index wrong for the last bucket
+        // the last 'hertz' value is not 8,000 (with sampling rate 16,000) but 7,999.999999
+        // thus calculating the bucket to 64, not 65.
+        // we're adjusting this here a tiny bit to ensure we have the same result
+        mels[MELS_SIZE - 1] = functions::mel_to_frequency(mels[MELS_SIZE - 1]);
+        if (mels[MELS_SIZE - 1] > high_frequency) {
+            mels[MELS_SIZE - 1] = high_frequency;
+        }
+        mels[MELS_SIZE - 1] -= 0.001;
+        bins[MELS_SIZE - 1] = bin_from_hertz(max_bin, mels[MELS_SIZE - 1], sampling_frequency);
+
+        ei_free(mels);
+
+        // both left and right bins have zero weight, so a filter covers (left, right)
+        size_t weights_size = 0;
+        for (uint16_t i = 0; i < num_filters; i++) {
+            assert(bins[i + 2] < power_spectrum_frame_size);
+            if (bins[i + 2] > bins[i] + 1) {
+                weights_size += bins[i + 2] - bins[i] - 1;
+            }
+        }
+
+        entry_t *e = (entry_t*)ei_calloc(1, sizeof(entry_t));
+        if (e) {
+            e->filters = (mel_filter_t*)ei_calloc(num_filters, sizeof(mel_filter_t));
+            e->weights = (float*)ei_calloc(weights_size > 0 ? weights_size : 1, sizeof(float));
+        }
+        if (!e || !e->filters || !e->weights) {
+            free_entry(e);
+            ei_free(bins);
+            return nullptr;
+        }
+
+        uint32_t offset = 0;
+        for (uint16_t i = 0; i < num_filters; i++) {
+            const uint16_t left = bins[i];
+            const uint16_t middle = bins[i + 1];
+            const uint16_t right = bins[i + 2];
+
+            mel_filter_t *filter = &e->filters[i];
+            filter->start = left + 1;
+            filter->count = right > left + 1 ? right - left - 1 : 0;
+            filter->middle = middle;
+            filter->offset = offset;
+
+            for (uint16_t bin = left + 1; bin < right; bin++) {
+                float weight = 0.0f; // middle is added separately with a weight of 1.0
+                if (bin < middle) {
+                    weight = (static_cast<float>(bin) - left) / (middle - left);
+                }
+                if (bin > middle) {
+                    weight = (right - static_cast<float>(bin)) / (right - middle);
+                }
+                e->weights[offset++] = weight;
+            }
+        }
+
+        ei_free(bins);
+
+        e->filterbank.filters = e->filters;
+        e->filterbank.weights = e->weights;
+        e->filterbank.num_filters = num_filters;
+        e->filterbank.power_spectrum_frame_size = power_spectrum_frame_size;
+        e->sampling_frequency = sampling_frequency;
+        e->num_filters = num_filters;
+        e->fft_length = fft_length;
+        e->low_frequency = low_frequency;
+        e->high_frequency = high_frequency;
+        e->v4 = v4;
+        return e;
+    }
+
+    static uint16_t bin_from_hertz(uint16_t fft_size, float hertz, uint32_t sampling_freq) {
+        return static_cast<uint16_t>(floor((fft_size + 1) * hertz / sampling_freq));
+    }
+
+    static void free_entry(entry_t *e) {
+        if (!e) {
+            return;
+        }
+        ei_free(e->filters);
+        ei_free(e->weights);
+        ei_free(e);
+    }
+
+    static entry_t *&head() {
+        static entry_t *list = nullptr;
+        return list;
+    }
+
+    static ei_cache_mutex_t &mutex() {
+        static ei_cache_mutex_t m;
+        return m;
+    }
+};
+
+} // namespace speechpy
+} // namespace ei
+
+#endif // _EIDSP_SPEECHPY_MEL_FILTERBANK_CACHE_H_
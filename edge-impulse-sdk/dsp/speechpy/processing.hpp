@@ -98,23 +98,32 @@ public:
             }
 
             // now we have the signal and we can preemphasize
-            for (size_t ix = 0; ix < length; ix++) {
-                float now = out_buffer[ix];
-
-                // under shift? read from end
-                if (offset + ix < static_cast<uint32_t>(_shift)) {
-                    out_buffer[ix] = now - (_cof * _end_of_signal_buffer[offset + ix]);
-                }
-                // otherwise read from history buffer
-                else {
-                    out_buffer[ix] = now - (_cof * _prev_buffer[0]);
-                }
-
-                // roll through and overwrite last element
-                if (_shift != 1) {
-                    numpy::roll(_prev_buffer, _shift, -1);
+            if (_shift == 1 && length > 0) {
+                // single sample history, the whole block can be done as a vector
+                float prev = offset == 0 ? _end_of_signal_buffer[0] : _prev_buffer[0];
+                float last = out_buffer[length - 1];
+                simd::preemphasis(out_buffer, length, prev, _cof);
+                _prev_buffer[0] = last;
+            }
+            else {
+                for (size_t ix = 0; ix < length; ix++) {
+                    float now = out_buffer[ix];
+
+                    // under shift? read from end
+                    if (offset + ix < static_cast<uint32_t>(_shift)) {
+                        out_buffer[ix] = now - (_cof * _end_of_signal_buffer[offset + ix]);
+                    }
+                    // otherwise read from history buffer
+                    else {
+                        out_buffer[ix] = now - (_cof * _prev_buffer[0]);
+                    }
+
+                    // roll through and overwrite last element
+                    if (_shift != 1) {
+                        numpy::roll(_prev_buffer, _shift, -1);
+                    }
+                    _prev_buffer[_shift - 1] = now;
                 }
-                _prev_buffer[_shift - 1] = now;
             }
 
             _next_offset_should_be += length;
@@ -384,10 +393,166 @@ namespace processing {
         return numframes;
     }
 
+    /**
+     * Sum of the first q rows of one column of the symmetrically padded matrix
+     * (same reflection as numpy::pad_1d_symmetric), where row 0 is the first row
+     * of the unpadded matrix. q may be negative or larger than rows; the padding
+     * repeats with a period of 2 * rows, so any window sum is the difference of
+     * two of these values.
+     * @param prefix Functor returning the sum of the first m rows of the column (0 <= m <= rows)
+     * @param rows Number of rows in the unpadded matrix
+     * @param q Row index in the padded matrix, relative to the first unpadded row
+     */
+    template <typename Prefix>
+    static inline double cmvnw_symmetric_cumsum(const Prefix &prefix, int32_t rows, int32_t q) {
+        if (q < 0) {
+            // the reflection is mirrored around row 0: rows [q, 0) equal rows [0, -q)
+            return -cmvnw_symmetric_cumsum(prefix, rows, -q);
+        }
+
+        const int32_t period = 2 * rows;
+        const double total = prefix(rows);
+        const int32_t m = q % period;
+
+        double sum = static_cast<double>(q / period) * 2.0 * total;
+        if (m <= rows) {
+            sum += prefix(m);
+        }
+        else {
+            sum += 2.0 * total - prefix(period - m);
+        }
+        return sum;
+    }
+
+    /**
+     * Column prefix sums of a matrix, prefix[m * cols + col] holds the sum of the
+     * first m rows of column col (prefix has rows + 1 rows, the first one zero).
+     * @param matrix Input matrix
+     * @param prefix Output buffer of (rows + 1) * cols
+     * @param prefix_sq Optional output buffer for the prefix sums of the squared values
+     */
+    static void cmvnw_prefix_sums(const matrix_t *matrix, double *prefix, double *prefix_sq) {
+        const size_t cols = matrix->cols;
+
+        for (size_t col = 0; col < cols; col++) {
+            prefix[col] = 0.0;
+            if (prefix_sq) {
+                prefix_sq[col] = 0.0;
+            }
+        }
+
+        for (size_t row = 0; row < matrix->rows; row++) {
+            const float *in = matrix->buffer + (row * cols);
+            const double *prev = prefix + (row * cols);
+            double *next = prefix + ((row + 1) * cols);
+
+            for (size_t col = 0; col < cols; col++) {
+                next[col] = prev[col] + static_cast<double>(in[col]);
+            }
+
+            if (prefix_sq) {
+                const double *prev_sq = prefix_sq + (row * cols);
+                double *next_sq = prefix_sq + ((row + 1) * cols);
+
+                for (size_t col = 0; col < cols; col++) {
+                    next_sq[col] = prev_sq[col] + static_cast<double>(in[col]) * static_cast<double>(in[col]);
+                }
+            }
+        }
+    }
+
+    /**
+     * Subtract the sliding window mean from every row, with the window sums
+     * taken from column prefix sums of the (unmodified) input.
+     * @param features_matrix Feature matrix, modified in place
+     * @param win_size The size of sliding window
+     * @param prefix Functor (m, col) returning the sum of the first m rows of column col
+     */
+    template <typename Prefix>
+    static int cmvnw_subtract_mean(matrix_t *features_matrix, uint16_t win_size, const Prefix &prefix) {
+        const int32_t rows = static_cast<int32_t>(features_matrix->rows);
+        const size_t cols = features_matrix->cols;
+        const int32_t pad_size = (win_size - 1) / 2;
+        const double scale = 1.0 / static_cast<double>(win_size);
+
+        float *mean = nullptr;
+        auto mean_ptr = EI_MAKE_TRACKED_POINTER(mean, cols);
+        EI_ERR_AND_RETURN_ON_NULL(mean, EIDSP_OUT_OF_MEM);
+
+        for (int32_t row = 0; row < rows; row++) {
+            const int32_t q0 = row - pad_size;
+
+            for (size_t col = 0; col < cols; col++) {
+                auto column_prefix = [&](int32_t m) { return prefix(static_cast<size_t>(m), col); };
+                const double window_sum = cmvnw_symmetric_cumsum(column_prefix, rows, q0 + win_size) -
+                    cmvnw_symmetric_cumsum(column_prefix, rows, q0);
+                mean[col] = static_cast<float>(window_sum * scale);
+            }
+
+            simd::subtract(features_matrix->buffer + (row * cols), mean, cols);
+        }
+
+        return EIDSP_OK;
+    }
+
+    /**
+     * Variance normalization and scaling steps of cmvnw, run on a matrix that
+     * already had the sliding window mean subtracted.
+     */
+    static int cmvnw_finish(matrix_t *features_matrix, uint16_t win_size, bool variance_normalization, bool scale) {
+        if (variance_normalization) {
+            const int32_t rows = static_cast<int32_t>(features_matrix->rows);
+            const size_t cols = features_matrix->cols;
+            const int32_t pad_size = (win_size - 1) / 2;
+            const double inv_win = 1.0 / static_cast<double>(win_size);
+
+            double *prefix = nullptr;
+            auto prefix_ptr = EI_MAKE_TRACKED_POINTER(prefix, (rows + 1) * cols * 2);
+            EI_ERR_AND_RETURN_ON_NULL(prefix, EIDSP_OUT_OF_MEM);
+            double *prefix_sq = prefix + ((rows + 1) * cols);
+
+            cmvnw_prefix_sums(features_matrix, prefix, prefix_sq);
+
+            for (size_t col = 0; col < cols; col++) {
+                auto column_prefix = [&](int32_t m) { return prefix[(m * cols) + col]; };
+                auto column_prefix_sq = [&](int32_t m) { return prefix_sq[(m * cols) + col]; };
+
+                for (int32_t row = 0; row < rows; row++) {
+                    const int32_t q0 = row - pad_size;
+                    const int32_t q1 = q0 + win_size;
+
+                    // population std of the window, var = E[x^2] - E[x]^2
+                    const double mean = (cmvnw_symmetric_cumsum(column_prefix, rows, q1) -
+                        cmvnw_symmetric_cumsum(column_prefix, rows, q0)) * inv_win;
+                    double var = (cmvnw_symmetric_cumsum(column_prefix_sq, rows, q1) -
+                        cmvnw_symmetric_cumsum(column_prefix_sq, rows, q0)) * inv_win - mean * mean;
+                    if (var < 0.0) {
+                        var = 0.0;
+                    }
+
+                    float *value = &features_matrix->buffer[(row * cols) + col];
+                    *value = *value / (static_cast<float>(sqrt(var)) + 1e-10);
+                }
+            }
+        }
+
+        if (scale) {
+            int ret = numpy::normalize(features_matrix);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+        }
+
+        return EIDSP_OK;
+    }
+
     /**
      * This function performs local cepstral mean and
      * variance normalization on a sliding window. The code assumes that
      * there is one observation per row.
+     * Window sums come from per-column running (prefix) sums over the symmetrically
+     * padded signal, so this runs in O(rows * cols) regardless of win_size and
+     * without materializing the padded matrix.
      * @param features_matrix input feature matrix, will be modified in place
      * @param win_size The size of sliding window for local normalization.
      *   Default=301 which is around 3s if 100 Hz rate is
@@ -404,87 +569,158 @@ namespace processing {
             return EIDSP_OK;
         }
 
-        uint16_t pad_size = (win_size - 1) / 2;
+        if (features_matrix->rows == 0) {
+            EIDSP_ERR(EIDSP_INPUT_MATRIX_EMPTY);
+        }
 
-        int ret;
-        float *features_buffer_ptr;
+        const size_t cols = features_matrix->cols;
 
-        // mean & variance normalization
-        EI_DSP_MATRIX(vec_pad, features_matrix->rows + (pad_size * 2), features_matrix->cols);
-        if (!vec_pad.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
-        }
+        double *prefix = nullptr;
+        auto prefix_ptr = EI_MAKE_TRACKED_POINTER(prefix, (features_matrix->rows + 1) * cols);
+        EI_ERR_AND_RETURN_ON_NULL(prefix, EIDSP_OUT_OF_MEM);
 
-        ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size);
+        // mean normalization, the prefix sums are taken before the matrix is modified
+        cmvnw_prefix_sums(features_matrix, prefix, nullptr);
+        int ret = cmvnw_subtract_mean(features_matrix, win_size,
+            [&](size_t m, size_t col) { return prefix[(m * cols) + col]; });
         if (ret != EIDSP_OK) {
             EIDSP_ERR(ret);
         }
 
-        EI_DSP_MATRIX(mean_matrix, vec_pad.cols, 1);
-        if (!mean_matrix.buffer) {
-            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        return cmvnw_finish(features_matrix, win_size, variance_normalization, scale);
+    }
+
+    /**
+     * Incremental cmvnw for continuous classification. The feature matrix there is a
+     * sliding window that gets a few new rows per slice; instead of re-summing the whole
+     * window on every inference this keeps running column sums of every row pushed so far
+     * (a ring of rows + 1 prefix sums), so a slice only costs O(new rows * cols) to
+     * account for and the mean normalization reads its window sums straight from the ring.
+     */
+    class cmvnw_running {
+public:
+        cmvnw_running()
+            : _prefix(nullptr), _rows(0), _cols(0), _rows_pushed(0)
+        {
         }
 
-        EI_DSP_MATRIX(window_variance, vec_pad.cols, 1);
-        if (!window_variance.buffer) {
-            return EIDSP_OUT_OF_MEM;
+        cmvnw_running(const cmvnw_running&) = delete;
+        cmvnw_running &operator=(const cmvnw_running&) = delete;
+
+        ~cmvnw_running() {
+            release();
         }
 
-        for (size_t ix = 0; ix < features_matrix->rows; ix++) {
-            // create a slice on the vec_pad
-            EI_DSP_MATRIX_B(window, win_size, vec_pad.cols, vec_pad.buffer + (ix * vec_pad.cols));
-            if (!window.buffer) {
-                EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        /**
+         * Set the shape of the feature window and drop all pushed rows
+         * @param rows Number of rows (frames) in the feature window
+         * @param cols Number of columns (coefficients) per row
+         */
+        int reset(size_t rows, size_t cols) {
+            if (rows == 0 || cols == 0) {
+                EIDSP_ERR(EIDSP_PARAMETER_INVALID);
             }
 
-            ret = numpy::mean_axis0(&window, &mean_matrix);
-            if (ret != EIDSP_OK) {
-                EIDSP_ERR(ret);
+            if (!_prefix || rows != _rows || cols != _cols) {
+                release();
+                _prefix = (double*)ei_dsp_calloc((rows + 1) * cols * sizeof(double), 1);
+                if (!_prefix) {
+                    EIDSP_ERR(EIDSP_OUT_OF_MEM);
+                }
+                _rows = rows;
+                _cols = cols;
             }
 
-            // subtract the mean for the features
-            for (size_t fm_col = 0; fm_col < features_matrix->cols; fm_col++) {
-                features_matrix->buffer[(ix * features_matrix->cols) + fm_col] =
-                    features_matrix->buffer[(ix * features_matrix->cols) + fm_col] - mean_matrix.buffer[fm_col];
+            clear();
+            return EIDSP_OK;
+        }
+
+        /**
+         * Drop all pushed rows (e.g. when the continuous audio state is cleared)
+         */
+        void clear() {
+            _rows_pushed = 0;
+            if (_prefix) {
+                memset(_prefix, 0, _cols * sizeof(double));
             }
         }
 
-        ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size);
-        if (ret != EIDSP_OK) {
-            EIDSP_ERR(ret);
+        bool is_ready() const {
+            return _prefix && _rows_pushed >= _rows;
         }
 
-        for (size_t ix = 0; ix < features_matrix->rows; ix++) {
-            // create a slice on the vec_pad
-            EI_DSP_MATRIX_B(window, win_size, vec_pad.cols, vec_pad.buffer + (ix * vec_pad.cols));
-            if (!window.buffer) {
+        size_t rows() const { return _rows; }
+        size_t cols() const { return _cols; }
+
+        /**
+         * Account for new rows appended at the end of the feature window
+         * @param buffer Row-major buffer of rows * cols() values
+         * @param rows Number of new rows
+         */
+        int push(const float *buffer, size_t rows) {
+            if (!_prefix) {
                 EIDSP_ERR(EIDSP_OUT_OF_MEM);
             }
 
-            if (variance_normalization == true) {
-                ret = numpy::std_axis0(&window, &window_variance);
-                if (ret != EIDSP_OK) {
-                    EIDSP_ERR(ret);
-                }
+            for (size_t row = 0; row < rows; row++) {
+                const double *prev = slot(_rows_pushed);
+                double *next = slot(_rows_pushed + 1);
+                const float *in = buffer + (row * _cols);
 
-                features_buffer_ptr = &features_matrix->buffer[ix * vec_pad.cols];
-                for (size_t col = 0; col < vec_pad.cols; col++) {
-                    *(features_buffer_ptr) = (*(features_buffer_ptr)) /
-                                             (window_variance.buffer[col] + 1e-10);
-                    features_buffer_ptr++;
+                for (size_t col = 0; col < _cols; col++) {
+                    next[col] = prev[col] + static_cast<double>(in[col]);
                 }
+                _rows_pushed++;
             }
+
+            return EIDSP_OK;
         }
 
-        if (scale) {
-            ret = numpy::normalize(features_matrix);
+        /**
+         * Same as cmvnw(), for a feature matrix that holds exactly the last rows() rows pushed
+         */
+        int apply(matrix_t *features_matrix, uint16_t win_size, bool variance_normalization, bool scale) {
+            if (win_size == 0) {
+                return EIDSP_OK;
+            }
+
+            if (features_matrix->rows != _rows || features_matrix->cols != _cols) {
+                EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+            }
+
+            if (!is_ready()) {
+                EIDSP_ERR(EIDSP_INPUT_MATRIX_EMPTY);
+            }
+
+            const uint64_t first_row = _rows_pushed - _rows;
+            const double *base = slot(first_row);
+
+            int ret = cmvnw_subtract_mean(features_matrix, win_size,
+                [&](size_t m, size_t col) { return slot(first_row + m)[col] - base[col]; });
             if (ret != EIDSP_OK) {
                 EIDSP_ERR(ret);
             }
+
+            return cmvnw_finish(features_matrix, win_size, variance_normalization, scale);
         }
 
-        return EIDSP_OK;
-    }
+private:
+        double *slot(uint64_t row) const {
+            return _prefix + ((row % (_rows + 1)) * _cols);
+        }
+
+        void release() {
+            if (_prefix) {
+                ei_dsp_free(_prefix, (_rows + 1) * _cols * sizeof(double));
+                _prefix = nullptr;
+            }
+        }
+
+        double *_prefix;
+        size_t _rows;
+        size_t _cols;
+        uint64_t _rows_pushed;
+    };
 
     /**
      * Perform normalization for MFE frames, this converts the signal to dB,
@@ -2,10 +2,12 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <cstdlib>
 #include <unistd.h>
 #include <fcntl.h>
-#include <jsoncpp/json/json.h>
 #include <syslog.h>
 #include <vosk_api.h>
 #include <alsa/asoundlib.h>
@@ -20,92 +22,64 @@
 
 #include "can_ids.h"
 #include "can.h"
+#include "audio_capture.h"
+#include "commands.h"
 #include "edge-impulse-sdk/classifier/ei_run_classifier.h"
 #include "edge-impulse-sdk/classifier/ei_classifier_types.h"
 
 #define SAMPLE_LENGTH   EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE  // Tamanho do frame de áudio (frame * samples per frame)
-#define SAMPLE_RATE     16000                               // Taxa de amostragem do microfone
-#define CHANNELS        1                                   // Mono
-#define PCM_DEVICE      "default"                           // Dispositivo de áudio ALSA padrão
-#define MAX_ATTEMPTS    10                                  // Tentativa para conectar ao microfone
-#define DELAY           5000                                // ms de delay entre tentativas
+#define SLICE_LENGTH    EI_CLASSIFIER_SLICE_SIZE            // Amostras por fatia na detecção contínua (janela / EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW)
+#define PREROLL_LENGTH  SLICE_LENGTH                        // Áudio anterior à detecção repassado ao Vosk (fatia que completou a wake word)
+#define PREROLL_BLOCK   (SAMPLE_RATE / 50)                  // Bloco de 20 ms usado para achar a pausa após a wake word
+#define COMMAND_CHUNK   (SAMPLE_RATE / 10)                  // Amostras enviadas ao Vosk por vez durante o comando (100 ms)
+#define COMMAND_TIMEOUT (5 * SAMPLE_RATE)                   // Áudio máximo de um comando (5 s)
+#define EARLY_COMMIT_CONFIDENCE 0.9f                        // Confiança mínima por palavra para aceitar o comando antes do endpoint
+#define EARLY_COMMIT_CHUNKS     2                           // Blocos seguidos com a mesma frase completa para aceitar o comando
+#define COMMANDS_FILE   "comandos.txt"                      // Tabela de comandos de voz (gera a gramática do Vosk)
 #define VOSK_LOG_LEVEL  1                                   // Nível de log do Vosk (0: desativado, 1: erros, 2: avisos)
+#define VOSK_CLOSED_GRAMMAR 1                               // Perfil de gramática fechada do Vosk, sem rescoring nem MBR (0 para comparar)
+#define VOSK_ALWAYS_ON  1                                   // Reconhecedor de comandos que reconstrói o pipeline de features só a cada 30 min (0 para comparar)
+#define VOSK_WORKER_THREAD 0                                // Decodificação do Vosk em thread dedicada (1) ou na thread principal (0)
 #define ENABLE_CAN      0                                   // Habilita ou desabilita o uso de CAN
+#define COUNT_ALLOCATIONS 0                                 // Conta as alocações (operator new) de cada comando, para diagnóstico
+#define LATENCY_BUCKETS 1000                                // Histograma de latência por bloco, 1 ms por faixa
 
-static std::vector<float> audio_frame;
+static_assert(EI_CLASSIFIER_RAW_SAMPLE_COUNT % EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW == 0,
+              "EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW deve dividir a janela do modelo em fatias iguais");
 
-/*
-*   Inicializa o dispositivo de áudio ALSA e configura os parâmetros necessários.
-*
-*   @return snd_pcm_t* Ponteiro para o dispositivo de áudio ALSA ou nullptr em caso de erro.
-*/
-snd_pcm_t* init_audio() {
-    snd_pcm_t *pcm_handle = nullptr;
-    snd_pcm_hw_params_t *params = nullptr;
-    int err;
-
-    std::cout << "[INFO] Inicializando captura de áudio ALSA em \"" << PCM_DEVICE << "\"..." << std::endl;
-
-    for (int attempt = 1; attempt <= MAX_ATTEMPTS; ++attempt) {
-        err = snd_pcm_open(&pcm_handle, PCM_DEVICE, SND_PCM_STREAM_CAPTURE, 0);
-        if (err >= 0) {
-            std::cout << "[INFO] Microfone aberto na tentativa " << attempt << " de " << MAX_ATTEMPTS << "." << std::endl;
-            
-            if ((err = snd_pcm_hw_params_malloc(&params)) < 0) {
-                std::cerr << "[ERRO] Falha ao alocar hw_params: " << snd_strerror(err) << std::endl;
-                snd_pcm_close(pcm_handle);
-                return nullptr;
-            }
+static AudioWindow audio_window;
 
-            if ((err = snd_pcm_hw_params_any(pcm_handle, params)) < 0 ||
-                (err = snd_pcm_hw_params_set_access(pcm_handle, params, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0 ||
-                (err = snd_pcm_hw_params_set_format(pcm_handle, params, SND_PCM_FORMAT_S16_LE)) < 0 ||
-                (err = snd_pcm_hw_params_set_channels(pcm_handle, params, CHANNELS)) < 0 ||
-                (err = snd_pcm_hw_params_set_rate(pcm_handle, params, SAMPLE_RATE, 0)) < 0 ||
-                (err = snd_pcm_hw_params(pcm_handle, params)) < 0) {
-
-                std::cerr << "[ERRO] Falha ao configurar hw_params: " << snd_strerror(err) << std::endl;
-                snd_pcm_hw_params_free(params);
-                snd_pcm_close(pcm_handle);
-                return nullptr;
-            }
-
-            snd_pcm_hw_params_free(params);
+// Latência de cada bloco enviado ao Vosk durante a missão, para p50/p99 sem guardar as amostras
+static uint64_t latency_histogram[LATENCY_BUCKETS + 1];
+static uint64_t latency_count = 0;
 
-            if ((err = snd_pcm_prepare(pcm_handle)) < 0) {
-                std::cerr << "[ERRO] Falha ao preparar PCM: " << snd_strerror(err) << std::endl;
-                snd_pcm_close(pcm_handle);
-                return nullptr;
-            }
-
-            std::cout << "[INFO] Áudio configurado para " << SAMPLE_RATE << " Hz, " << CHANNELS << " canal(is), formato S16_LE." << std::endl;
-            return pcm_handle;
-        }
-
-        std::cerr << "[WARN] Tentativa " << attempt << " falhou: " << snd_strerror(err) << std::endl;
-
-        if (attempt < MAX_ATTEMPTS) {
-            std::cerr << "[INFO] Aguardando " << DELAY << "ms antes de tentar novamente...\n";
-            usleep(DELAY * 1000);
-        }
-    }
+#if COUNT_ALLOCATIONS
+// Substitui o operator new global, o que também conta as alocações feitas dentro da libvosk
+static std::atomic<uint64_t> allocation_count{0};
 
-    std::cerr << "[ERRO] Não foi possível inicializar o microfone após " << MAX_ATTEMPTS << " tentativas.\n";
-    return nullptr;
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
 }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
 
 /*
 *  Verifica se o sinal de áudio é constante (sem variação).
 *  Evita leitura de áudios inválidos (ex: microfone desconectado ou travado).
 *
-*  @param buffer Buffer contendo os samples de áudio.
-*  @param size Tamanho do buffer.
+*  @param window Janela do buffer circular contendo os samples de áudio.
 *  @return true se o sinal for constante (todos os valores iguais), false se houver variação.
 */
-bool check_constant_signal(const int16_t* buffer, size_t size) {
-    int16_t first = buffer[0];
-    for (size_t i = 1; i < size; ++i) {
-        if (buffer[i] != first) return false;
+bool check_constant_signal(const AudioWindow& window) {
+    int16_t first = window.first[0];
+    for (size_t i = 1; i < window.first_len; ++i) {
+        if (window.first[i] != first) return false;
+    }
+    for (size_t i = 0; i < window.second_len; ++i) {
+        if (window.second[i] != first) return false;
     }
     return true;
 }
@@ -119,55 +93,52 @@ bool check_constant_signal(const int16_t* buffer, size_t size) {
 *   @return 0 em caso de sucesso, -1 se o offset ou length forem inválidos. 
 */
 int get_signal_audio_data(size_t offset, size_t length, float *out_ptr) {
-    if (offset + length > audio_frame.size()) return -1;
-    memcpy(out_ptr, audio_frame.data() + offset, length * sizeof(float));
+    if (offset + length > audio_window.size()) return -1;
+
+    // A janela pode estar dividida em dois trechos do buffer circular; cada trecho é convertido em bloco (NEON no aarch64)
+    size_t first = 0;
+    if (offset < audio_window.first_len) {
+        first = std::min(length, audio_window.first_len - offset);
+        ei::simd::int16_to_float(audio_window.first + offset, out_ptr, first, 1.0f / 32768.0f);
+    }
+    if (first < length) {
+        ei::simd::int16_to_float(audio_window.second + (offset + first - audio_window.first_len),
+                                 out_ptr + first, length - first, 1.0f / 32768.0f);
+    }
     return 0;
 }
 
 /*
-*   Captura um frame de áudio do microfone e preenche a estrutura signal_t.
+*   Preenche a estrutura signal_t com uma janela do buffer circular, sem copiar as amostras.
+*   A conversão para float acontece sob demanda em get_signal_audio_data.
 *
 *   @param signal Ponteiro para a estrutura signal_t a ser preenchida.
-*   @param pcm_handle Ponteiro para o dispositivo de áudio PCM.
-*   @return true se o frame foi capturado com sucesso, false em caso de erro.
+*   @param window Janela de áudio do buffer circular.
 */
-bool get_audio_frame_signal(signal_t *signal, snd_pcm_t *pcm_handle) {
-    short buffer[SAMPLE_LENGTH];
-    int err = snd_pcm_readi(pcm_handle, buffer, SAMPLE_LENGTH);
-    if (err != SAMPLE_LENGTH) {
-        std::cerr << "[ERRO] Falha na leitura do microfone: " << snd_strerror(err) << std::endl;
-        return false;
-    }
-
-    audio_frame.resize(SAMPLE_LENGTH);
-    for (size_t i = 0; i < SAMPLE_LENGTH; i++) {
-        audio_frame[i] = buffer[i] / 32768.0f;
-    }
-
-    signal->total_length = audio_frame.size();
+void get_audio_frame_signal(signal_t *signal, const AudioWindow& window) {
+    audio_window = window;
+    signal->total_length = audio_window.size();
     signal->get_data = &get_signal_audio_data;
-    return true;
 }
 
 /*
 *   Detecta a palavra-chave "Zenira" no áudio capturado.
+*   Cada chamada recebe uma fatia nova (SLICE_LENGTH amostras); o classificador mantém a janela
+*   deslizante de 1 s e só calcula o MFCC das linhas da fatia nova.
 *
-*   @param audio_samples Vetor contendo os samples de áudio capturados.
+*   @param window Fatia de áudio do buffer circular, imediatamente após a fatia anterior.
 *   @param signal Ponteiro para a estrutura signal_t que será preenchida.
-*   @param pcm_handle Ponteiro para o dispositivo de áudio PCM.
 *   @return true se a palavra-chave foi detectada, false caso contrário ou em caso de erro.
 */
-bool wake_word_detected(std::vector<float>& audio_samples, signal_t* signal, snd_pcm_t* pcm_handle) {
-    if (!get_audio_frame_signal(signal, pcm_handle)) {
-        std::cerr << "[ERRO] Falha ao capturar frame de áudio.\n";
-        return false;
-    }
+bool wake_word_detected(const AudioWindow& window, signal_t* signal) {
+    get_audio_frame_signal(signal, window);
 
     ei_impulse_result_t result;
-    EI_IMPULSE_ERROR res = run_classifier(signal, &result, false);
+    EI_IMPULSE_ERROR res = run_classifier_continuous(signal, &result, false);
 
     if (res != EI_IMPULSE_OK) {
         std::cerr << "Erro ao classificar: " << res << std::endl;
+        run_classifier_flush();
         return false;
     }
 
@@ -178,6 +149,7 @@ bool wake_word_detected(std::vector<float>& audio_samples, signal_t* signal, snd
 
         if (label == "Zenira" && value > 0.8f) {
             std::cout << "[Wake word detectada!]" << std::endl;
+            run_classifier_flush();
             return true;
         }
     }
@@ -187,28 +159,202 @@ bool wake_word_detected(std::vector<float>& audio_samples, signal_t* signal, snd
 
 /*
 *   Cria um reconhecedor de comandos Vosk com um modelo pré-carregado.
+*   Configura o endpointer para comandos curtos: até 3 s de silêncio antes da fala,
+*   0,3 s de silêncio para encerrar após a fala e no máximo 5 s de comando. Como a gramática é fechada,
+*   o Vosk também encerra assim que a hipótese parcial for uma frase completa e confiável (early commit)
+*   e usa o perfil de gramática fechada: sem rescoring e resultado direto do melhor caminho, sem MBR.
+*   O modo always-on mantém o pipeline de features entre comandos e só o reconstrói a cada 30 min de
+*   áudio, preservando a adaptação do i-vector, em vez de a cada 10 min. Com VOSK_WORKER_THREAD a decodificação roda numa thread
+*   dedicada do Vosk e a thread principal apenas enfileira o áudio.
 *
 *   @param model Ponteiro para o modelo Vosk carregado.
+*   @param commands Tabela de comandos que define a gramática.
 *   @return Ponteiro para o reconhecedor de comandos ou nullptr em caso de erro.
 */
-VoskRecognizer* create_command_recognizer(VoskModel* model) {
-    const char* grammar = R"([
-        "mudar velocidade para dez",       "velocidade para dez",       "velocidade dez",
-        "mudar velocidade para vinte",     "velocidade para vinte",     "velocidade vinte",
-        "mudar velocidade para trinta",    "velocidade para trinta",    "velocidade trinta",
-        "mudar velocidade para quarenta",  "velocidade para quarenta",  "velocidade quarenta",
-        "mudar velocidade para cinquenta", "velocidade para cinquenta", "velocidade cinquenta",
-        "mudar velocidade para sessenta",  "velocidade para sessenta",  "velocidade sessenta",
-        "mudar velocidade para setenta",   "velocidade para setenta",   "velocidade setenta",
-        "mudar velocidade para oitenta",   "velocidade para oitenta",   "velocidade oitenta",
-        "mudar velocidade para noventa",   "velocidade para noventa",   "velocidade noventa",
-        "mudar velocidade para cem",       "velocidade para cem",       "velocidade cem",
-        "desligar motor", "motor off",
-        "ligar motor", "motor on",
-        "virar a direita", "virar a esquerda", "seguir reto"
-    ])";
-
-    return vosk_recognizer_new_grm(model, SAMPLE_RATE, grammar);
+VoskRecognizer* create_command_recognizer(VoskModel* model, const CommandTable& commands) {
+    VoskRecognizer* recognizer = vosk_recognizer_new_grm(model, SAMPLE_RATE, commands.grammar().c_str());
+    if (!recognizer) return nullptr;
+
+    vosk_recognizer_set_endpointer_delays(recognizer, 3.0f, 0.3f, COMMAND_TIMEOUT / static_cast<float>(SAMPLE_RATE));
+    vosk_recognizer_set_early_commit(recognizer, EARLY_COMMIT_CONFIDENCE, EARLY_COMMIT_CHUNKS);
+    vosk_recognizer_set_closed_grammar(recognizer, VOSK_CLOSED_GRAMMAR);
+    vosk_recognizer_set_always_on(recognizer, VOSK_ALWAYS_ON);
+    vosk_recognizer_set_worker_thread(recognizer, VOSK_WORKER_THREAD);
+    return recognizer;
+}
+
+/*
+*   Escolhe a amostra a partir da qual o Vosk passa a ouvir o comando.
+*   A wake word termina dentro da última fatia classificada, então o comando pode já ter começado nela.
+*   Procura o bloco de 20 ms de menor energia nessa fatia (a pausa depois de "Zenira") e começa dali,
+*   descartando o final da palavra-chave sem perder o início do comando.
+*
+*   @param ring Buffer circular de áudio.
+*   @param cursor Fim da última fatia classificada (momento da detecção).
+*   @return Índice absoluto da primeira amostra a ser enviada ao Vosk.
+*/
+uint64_t command_start(const AudioRingBuffer& ring, uint64_t cursor) {
+    uint64_t start = cursor - PREROLL_LENGTH;
+    AudioWindow window = ring.window(start, PREROLL_LENGTH);
+
+    uint64_t best = cursor;
+    int64_t best_energy = INT64_MAX;
+    for (size_t block = 0; block + PREROLL_BLOCK <= window.size(); block += PREROLL_BLOCK) {
+        int64_t energy = 0;
+        for (size_t i = block; i < block + PREROLL_BLOCK; ++i) {
+            int32_t sample = window.at(i);
+            energy += sample * sample;
+        }
+        if (energy < best_energy) {
+            best_energy = energy;
+            best = start + block;
+        }
+    }
+    return best;
+}
+
+/*
+*   Envia uma janela do buffer circular ao reconhecedor Vosk em uma única chamada.
+*   Se a janela dá a volta no buffer, as duas partes são copiadas para um bloco contíguo: o early
+*   commit conta blocos estáveis por chamada, e duas chamadas avançariam a contagem duas vezes.
+*
+*   @param recognizer Reconhecedor de comandos Vosk.
+*   @param window Janela de áudio do buffer circular, com no máximo COMMAND_CHUNK amostras.
+*   @return true se o Vosk detectou fim de fala (resultado disponível), false caso contrário.
+*/
+bool feed_recognizer(VoskRecognizer* recognizer, const AudioWindow& window) {
+    static int16_t contiguo[COMMAND_CHUNK];
+
+    if (window.second_len == 0) {
+        return vosk_recognizer_accept_waveform_s(recognizer, window.first, static_cast<int>(window.first_len));
+    }
+    std::copy(window.first, window.first + window.first_len, contiguo);
+    std::copy(window.second, window.second + window.second_len, contiguo + window.first_len);
+    return vosk_recognizer_accept_waveform_s(recognizer, contiguo, static_cast<int>(window.size()));
+}
+
+/*
+*   Memória residente (RSS) do processo, lida de /proc/self/status.
+*
+*   @return RSS em kB ou -1 se não for possível ler.
+*/
+long resident_memory_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) return std::atol(line.c_str() + 6);
+    }
+    return -1;
+}
+
+/*
+*   Registra no histograma a latência de um bloco enviado ao Vosk.
+*/
+void record_latency(std::chrono::steady_clock::duration latencia) {
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(latencia).count();
+    latency_histogram[std::min<long long>(ms, LATENCY_BUCKETS)]++;
+    latency_count++;
+}
+
+/*
+*   Percentil da latência por bloco registrada até agora.
+*
+*   @param percentil Entre 0 e 1.
+*   @return Latência em ms (LATENCY_BUCKETS significa LATENCY_BUCKETS ms ou mais).
+*/
+int latency_percentile(double percentil) {
+    if (latency_count == 0) return 0;
+    uint64_t alvo = std::min(static_cast<uint64_t>(percentil * latency_count), latency_count - 1);
+    uint64_t acumulado = 0;
+    for (int ms = 0; ms <= LATENCY_BUCKETS; ms++) {
+        acumulado += latency_histogram[ms];
+        if (acumulado > alvo) return ms;
+    }
+    return LATENCY_BUCKETS;
+}
+
+/*
+*   Captura um comando de voz, alimentando o Vosk em blocos de COMMAND_CHUNK amostras a partir do cursor.
+*
+*   O fim do comando é decidido pela contagem de amostras, não pelo relógio:
+*   - o endpointer do Vosk encerra após o silêncio que segue a fala (ou após silêncio inicial longo),
+*     ou antes disso pelo early commit, quando a frase da gramática já está completa;
+*   - após COMMAND_TIMEOUT amostras a captura é encerrada e o Vosk finaliza o que ouviu até ali.
+*   Se a captura sobrescrever o áudio antes de ele ser lido, o cursor é ressincronizado com o
+*   produtor, como no laço da palavra-chave.
+*
+*   Registra por modo de decodificação (VOSK_WORKER_THREAD) e perfil (VOSK_CLOSED_GRAMMAR) o fator de
+*   tempo real (tempo em que a thread principal ficou bloqueada no Vosk / duração do áudio), a latência
+*   entre a chegada do último bloco de áudio e o resultado e a memória residente. Com a thread dedicada
+*   o endpoint pode vir um bloco depois, o que aparece no áudio processado. Registra também p50/p99/máximo
+*   da latência por bloco desde o início da missão (VOSK_ALWAYS_ON) e, com COUNT_ALLOCATIONS, as
+*   alocações feitas durante o comando.
+*
+*   @param recognizer Reconhecedor de comandos Vosk, já rearmado.
+*   @param ring Buffer circular de áudio.
+*   @param cursor Primeira amostra do comando; ao retornar aponta para depois do áudio consumido.
+*   @param resultado Resultado estruturado, com o vetor de palavras fornecido pelo chamador.
+*   @return true se alguma palavra foi reconhecida.
+*/
+bool capture_command(VoskRecognizer* recognizer, AudioRingBuffer& ring, uint64_t& cursor, VoskResult* resultado) {
+    auto inicio = std::chrono::steady_clock::now();
+#if COUNT_ALLOCATIONS
+    uint64_t alocacoes = allocation_count.load(std::memory_order_relaxed);
+#endif
+    uint64_t primeira = cursor;
+    uint64_t fim = cursor + COMMAND_TIMEOUT;
+
+    bool reconhecido = false;
+    bool endpoint = false;
+    std::chrono::steady_clock::duration bloqueado{0};
+    std::chrono::steady_clock::time_point chegada;
+    while (cursor < fim && ring.wait_for(cursor + COMMAND_CHUNK)) {
+        chegada = std::chrono::steady_clock::now();
+        AudioWindow chunk = ring.window(cursor, COMMAND_CHUNK);
+        endpoint = feed_recognizer(recognizer, chunk);
+
+        if (!ring.is_intact(cursor)) {
+            std::cerr << "[WARN] Reconhecimento atrasado em relação à captura. Ressincronizando...\n";
+            cursor = ring.write_index();
+        } else {
+            cursor += COMMAND_CHUNK;
+        }
+
+        if (endpoint) {
+            // Resultado estruturado: palavras e ids vêm direto do reconhecedor, sem gerar nem interpretar JSON
+            reconhecido = vosk_recognizer_get_result(recognizer, resultado) > 0;
+        }
+        auto latencia = std::chrono::steady_clock::now() - chegada;
+        bloqueado += latencia;
+        record_latency(latencia);
+        if (endpoint) break;
+    }
+
+    if (!endpoint) {
+        // Tempo esgotado sem fim de fala: o comando pode estar completo mesmo sem o silêncio final
+        reconhecido = vosk_recognizer_get_result(recognizer, resultado) > 0;
+    }
+
+    auto agora = std::chrono::steady_clock::now();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(agora - inicio).count();
+    auto audio_ms = (cursor - primeira) * 1000 / SAMPLE_RATE;
+    auto bloqueado_ms = std::chrono::duration_cast<std::chrono::milliseconds>(bloqueado).count();
+    std::cout << "[INFO] Captura de comando (" << (VOSK_WORKER_THREAD ? "thread dedicada" : "thread principal")
+              << (VOSK_CLOSED_GRAMMAR ? ", gramática fechada" : ", com rescoring") << "): " << ms << " ms, " << audio_ms << " ms de áudio processados, RTF "
+              << (audio_ms ? static_cast<float>(bloqueado_ms) / audio_ms : 0.0f);
+    if (endpoint) {
+        std::cout << ", resultado " << std::chrono::duration_cast<std::chrono::milliseconds>(agora - chegada).count()
+                  << " ms após o último áudio";
+    }
+    std::cout << " (RSS: " << resident_memory_kb() / 1024 << " MB).\n";
+    std::cout << "[INFO] Latência por bloco desde o início (" << (VOSK_ALWAYS_ON ? "always-on" : "pipeline recriado")
+              << ", " << latency_count << " blocos): p50 " << latency_percentile(0.5) << " ms, p99 "
+              << latency_percentile(0.99) << " ms, máx " << latency_percentile(1.0) << " ms.\n";
+#if COUNT_ALLOCATIONS
+    std::cout << "[INFO] Alocações durante o comando: "
+              << allocation_count.load(std::memory_order_relaxed) - alocacoes << ".\n";
+#endif
+    return reconhecido;
 }
 
 /*
@@ -274,23 +420,72 @@ void send_command_tail(int can_sock, int16_t posicao_graus_cem) {
 #endif
 }
 
+/*
+*   Executa a ação CAN de um comando da tabela.
+*
+*   @param can_sock Socket CAN já configurado.
+*   @param command Comando reconhecido.
+*/
+void execute_command(int can_sock, const Command& command) {
+    std::cout << "[INFO] " << command.message << "\n";
+    switch (command.action) {
+        case CommandAction::MOTOR:
+            send_command_motor(can_sock, static_cast<uint8_t>(command.value));
+            break;
+        case CommandAction::TAIL:
+            send_command_tail(can_sock, static_cast<int16_t>(command.value));
+            break;
+        case CommandAction::NONE:
+            break;
+    }
+}
+
+/*
+*   Milissegundos decorridos desde inicio.
+*/
+long elapsed_ms(std::chrono::steady_clock::time_point inicio) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - inicio).count();
+}
+
 int main() {
+    auto inicio = std::chrono::steady_clock::now();
     setlogmask(LOG_UPTO(LOG_ERR));
     std::cout << "[INFO] Carregando modelo Vosk...\n";
 
+    // Os grafos do modelo são mapeados em memória e paginados sob demanda; os modelos de
+    // rescoring só são lidos se algum reconhecedor os usar
     vosk_set_log_level(VOSK_LOG_LEVEL);
     VoskModel* model = vosk_model_new("vosk-models/vosk-model-small-pt-0.3");
     if (!model) {
         std::cerr << "[ERRO] Falha ao carregar modelo Vosk.\n";
         return 1;
     }
+    std::cout << "[INFO] Modelo Vosk carregado em " << elapsed_ms(inicio) << " ms (RSS: "
+              << resident_memory_kb() / 1024 << " MB).\n";
+
+    // Tabela de comandos: gera a gramática e despacha o resultado pelos ids de palavra
+    CommandTable commands;
+    if (!commands.load(COMMANDS_FILE, model)) {
+        vosk_model_free(model);
+        return 1;
+    }
+
+    // Reconhecedor único, rearmado a cada wake word: decodificador, pipeline de features e grafo
+    // da gramática são alocados aqui uma vez e reaproveitados
+    VoskRecognizer* recognizer = create_command_recognizer(model, commands);
+    if (!recognizer) {
+        std::cerr << "[ERRO] Falha ao criar o reconhecedor de comandos.\n";
+        vosk_model_free(model);
+        return 1;
+    }
 
     signal_t signal;
     snd_pcm_t* audio = init_audio();
     if (!audio) return 1;
 
-    std::vector<float> float_samples(SAMPLE_LENGTH);
-    short raw_samples[SAMPLE_LENGTH];
+    AudioCapture capture(audio);
+    AudioRingBuffer& ring = capture.ring();
+    if (!capture.start()) return 1;
 
 #if ENABLE_CAN
     int can_sock = setup_can();
@@ -303,144 +498,65 @@ int main() {
     std::cout << "[INFO] CAN desativado para testes locais.\n";
 #endif
 
+    std::cout << "[INFO] Pronto em " << elapsed_ms(inicio) << " ms desde o início (RSS: "
+              << resident_memory_kb() / 1024 << " MB).\n";
     std::cout << "[INFO] Aguardando palavra de ativação: \"zenira\"...\n";
 
-    while (true) {
-        int err = snd_pcm_readi(audio, raw_samples, SAMPLE_LENGTH);
-        if (err != SAMPLE_LENGTH) {
-            std::cerr << "[ERRO] Falha ao ler dados de áudio: " << snd_strerror(err) << std::endl;
-            continue;
-        }
+    run_classifier_init();
+    uint64_t cursor = ring.write_index();
 
-        if (check_constant_signal(raw_samples, SAMPLE_LENGTH)) {
+    while (ring.wait_for(cursor + SLICE_LENGTH)) {
+        AudioWindow window = ring.window(cursor, SLICE_LENGTH);
+
+        if (check_constant_signal(window)) {
             std::cerr << "[INFO] Sinal de áudio constante detectado. Ignorando frame.\n";
+            run_classifier_flush();
+            cursor += SLICE_LENGTH;
             continue;
         }
 
-        for (int i = 0; i < SAMPLE_LENGTH; i++) {
-            float_samples[i] = raw_samples[i] / 32768.0f;
-        }
+        bool detected = wake_word_detected(window, &signal);
 
+        if (!ring.is_intact(cursor)) {
+            std::cerr << "[WARN] Classificação atrasada em relação à captura. Ressincronizando...\n";
+            run_classifier_flush();
+            cursor = ring.write_index();
+            continue;
+        }
+        cursor += SLICE_LENGTH;
 
-        if (wake_word_detected(float_samples, &signal, audio)) {
+        if (detected) {
             std::cout << "[INFO] Iniciando reconhecimento de comandos com Vosk...\n";
-            VoskRecognizer* recognizer = create_command_recognizer(model);
-
-            bool comandoReconhecido = false;
-            time_t inicio = time(nullptr);
-            while (difftime(time(nullptr), inicio) < 5.0) {
-                snd_pcm_readi(audio, raw_samples, SAMPLE_LENGTH / 2);
-                if (vosk_recognizer_accept_waveform(recognizer, (const char*)raw_samples, (SAMPLE_LENGTH / 2) * sizeof(short))) {
-                    std::string result = vosk_recognizer_result(recognizer);
-                    Json::Reader reader;
-                    Json::Value root;
-                    if (reader.parse(result, root)) {
-                        std::string comando = root["text"].asString();
-                        std::cout << "[COMANDO] Detectado: \"" << comando << "\"\n";
-
-                        uint8_t dados[] = {0x01};
-
-                        if (comando == "desligar motor") {
-                            std::cout << "[INFO] Desligando motor.\n";
-                            send_command_motor(can_sock, 0);
-                        }
-                        else if (comando == "ligar motor") {
-                            std::cout << "[INFO] Ligando motor.\n";
-                            send_command_motor(can_sock, 5); 
-                        }
-                        else if (comando == "mudar velocidade para dez" || 
-                                 comando == "velocidade para dez" || 
-                                 comando == "velocidade dez") {
-                            std::cout << "[INFO] Ajustando velocidade do motor para 10%.\n";
-                            send_command_motor(can_sock, 10);
-                        }
-                        else if (comando == "mudar velocidade para vinte" || 
-                                 comando == "velocidade para vinte" || 
-                                 comando == "velocidade vinte") {
-                            std::cout << "[INFO] Ajustando velocidade do motor para 20%.\n";
-                            send_command_motor(can_sock, 20);
-                        }
-                        else if (comando == "mudar velocidade para trinta" || 
-                                 comando == "velocidade para trinta" || 
-                                 comando == "velocidade trinta") {
-                            std::cout << "[INFO] Ajustando velocidade do motor para 30%.\n";
-                            send_command_motor(can_sock, 30);
-                        }
-                        else if (comando == "mudar velocidade para quarenta" || 
-                                 comando == "velocidade para quarenta" || 
-                                 comando == "velocidade quarenta") {
-                            std::cout << "[INFO] Ajustando velocidade do motor para 40%.\n";
-                            send_command_motor(can_sock, 40);
-                        }
-                        else if (comando == "mudar velocidade para cinquenta" || 
-                                 comando == "velocidade para cinquenta" || 
-                                 comando == "velocidade cinquenta") {
-                            std::cout << "[INFO] Ajustando velocidade do motor para 50%.\n";
-                            send_command_motor(can_sock, 50);
-                        }
-                        else if (comando == "mudar velocidade para sessenta" || 
-                                 comando == "velocidade para sessenta" || 
-                                 comando == "velocidade sessenta") {
-                            std::cout << "[INFO] Ajustando velocidade do motor para 60%.\n";
-                            send_command_motor(can_sock, 60);
-                        }
-                        else if (comando == "mudar velocidade para setenta" || 
-                                 comando == "velocidade para setenta" || 
-                                 comando == "velocidade setenta") {
-                            std::cout << "[INFO] Ajustando velocidade do motor para 70%.\n";
-                            send_command_motor(can_sock, 70);
-                        }
-                        else if (comando == "mudar velocidade para oitenta" || 
-                                 comando == "velocidade para oitenta" || 
-                                 comando == "velocidade oitenta") {
-                            std::cout << "[INFO] Ajustando velocidade do motor para 80%.\n";
-                            send_command_motor(can_sock, 80);
-                        }
-                        else if (comando == "mudar velocidade para noventa" || 
-                                 comando == "velocidade para noventa" || 
-                                 comando == "velocidade noventa") {
-                            std::cout << "[INFO] Ajustando velocidade do motor para 90%.\n";
-                            send_command_motor(can_sock, 90);
-                        }
-                        else if (comando == "mudar velocidade para cem" || 
-                                 comando == "velocidade para cem" || 
-                                 comando == "velocidade cem") {
-                            std::cout << "[INFO] Ajustando velocidade do motor para 100%.\n";
-                            send_command_motor(can_sock, 100);
-                        }
-                        else if (comando == "virar a direita") {
-                            std::cout << "[INFO] Virando a rabeta para a direita.\n";
-                            send_command_tail(can_sock, +3000);
-                        }
-                        else if (comando == "virar a esquerda") {
-                            std::cout << "[INFO] Virando a rabeta para a esquerda.\n";
-                            send_command_tail(can_sock, -3000);
-                        }
-                        else if (comando == "seguir reto") {
-                            std::cout << "[INFO] Ajustando rabeta para posição zero.\n";
-                            send_command_tail(can_sock, 0);
-                        }
-                        else if (!comando.empty()) {
-                            std::cout << "[INFO] Comando não reconhecido: " << comando << "\n";
-                        }
-
-                        comandoReconhecido = true;
-                        break;
-                    }
-                }
+            vosk_recognizer_rearm(recognizer);
+
+            // Pré-roll: o áudio logo após a wake word já está no buffer circular e é enviado de imediato,
+            // mais rápido que o tempo real, então "Zenira, velocidade cinquenta" funciona sem pausa
+            cursor = command_start(ring, cursor);
+            VoskWord palavras[MAX_COMMAND_WORDS];
+            VoskResult resultado = {};
+            resultado.max_words = MAX_COMMAND_WORDS;
+            resultado.words = palavras;
+
+            if (!capture_command(recognizer, ring, cursor, &resultado)) {
+                std::cout << "[INFO] Nenhum comando detectado dentro do tempo limite.\n";
             }
+            else {
+                std::cout << "[COMANDO] Detectado: \"" << resultado.text << "\"\n";
 
-            vosk_recognizer_free(recognizer);
+                // Despacho pela sequência de ids de palavra, sem comparar texto
+                const Command* comando = commands.find(palavras, resultado.num_words);
+                if (comando && comando->action != CommandAction::NONE) execute_command(can_sock, *comando);
+                else std::cout << "[INFO] Comando não reconhecido: " << resultado.text << "\n";
+            }
 
-            if (!comandoReconhecido) std::cout << "[INFO] Nenhum comando detectado dentro do tempo limite.\n";
             std::cout << "[INFO] Retornando ao modo de escuta da palavra-chave \"zenira\"...\n";
         }
-
-        usleep(10000);
     }
 
+    capture.stop();
+    run_classifier_deinit();
+    vosk_recognizer_free(recognizer);
     vosk_model_free(model);
-    snd_pcm_close(audio);
 
 #if ENABLE_CAN
     close_can(can_sock);
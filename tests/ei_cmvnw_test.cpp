@@ -0,0 +1,210 @@
+/*
+*   Teste do cmvnw por somas de prefixo (speechpy::processing::cmvnw e cmvnw_running).
+*
+*   Compara com a implementação anterior, copiada abaixo, que montava a matriz com padding simétrico
+*   e recalculava média e desvio de cada janela: O(linhas * janela * colunas). As somas agora são em
+*   double, então a diferença é de arredondamento de float. Testa vários formatos e janelas, com e
+*   sem normalização da variância e escala, e o modo contínuo (cmvnw_running), que recebe só as
+*   linhas novas de cada fatia. Mede o tempo na janela do MFCC do modelo (50 x 13, janela 101).
+*
+*   No Pi:  cmake -DEI_DSP_TESTS=ON ... && make ei_cmvnw_test && ./ei_cmvnw_test
+*   No host, a partir da raiz do repositório:
+*       g++ -O2 -std=c++17 -I. -Iedge-impulse-sdk -Imodel-parameters -Itflite-model tests/ei_cmvnw_test.cpp \
+*           edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp \
+*           edge-impulse-sdk/dsp/memory.cpp edge-impulse-sdk/porting/posix/debug_log.cpp \
+*           edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp -lpthread -o ei_cmvnw_test
+*
+*   @return 0 se os dois cmvnw ficaram dentro da tolerância da implementação anterior.
+*/
+#include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+#include "ei_dsp_test.h"
+
+#include <vector>
+
+using namespace ei;
+
+#define TOLERANCIA      1e-4f                               // Erro relativo aceito contra o cmvnw anterior
+#define WINDOW_ROWS     50                                  // Linhas da janela do MFCC no modo contínuo
+#define STREAM_ROWS     400                                 // Linhas geradas para o modo contínuo
+
+struct Caso {
+    size_t rows;
+    size_t cols;
+    uint16_t win_size;
+};
+
+// A variância de uma única linha é 0: o código anterior dividia o arredondamento por 1e-10 e o
+// novo devolve 0, então esse formato só é comparado sem normalização da variância
+static const Caso casos[] = {
+    { 50, 13, 101 }, { 50, 13, 301 }, { 99, 13, 101 }, { 10, 5, 3 }, { 7, 4, 1 }, { 20, 40, 11 }, { 1, 13, 101 },
+};
+
+// cmvnw antes das somas de prefixo
+static int cmvnw_anterior(matrix_t *features_matrix, uint16_t win_size, bool variance_normalization, bool scale)
+{
+    if (win_size == 0) {
+        return EIDSP_OK;
+    }
+
+    uint16_t pad_size = (win_size - 1) / 2;
+
+    int ret;
+    float *features_buffer_ptr;
+
+    // mean & variance normalization
+    EI_DSP_MATRIX(vec_pad, features_matrix->rows + (pad_size * 2), features_matrix->cols);
+    if (!vec_pad.buffer) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+
+    ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    EI_DSP_MATRIX(mean_matrix, vec_pad.cols, 1);
+    if (!mean_matrix.buffer) {
+        EIDSP_ERR(EIDSP_OUT_OF_MEM);
+    }
+
+    EI_DSP_MATRIX(window_variance, vec_pad.cols, 1);
+    if (!window_variance.buffer) {
+        return EIDSP_OUT_OF_MEM;
+    }
+
+    for (size_t ix = 0; ix < features_matrix->rows; ix++) {
+        // create a slice on the vec_pad
+        EI_DSP_MATRIX_B(window, win_size, vec_pad.cols, vec_pad.buffer + (ix * vec_pad.cols));
+        if (!window.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        ret = numpy::mean_axis0(&window, &mean_matrix);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+
+        // subtract the mean for the features
+        for (size_t fm_col = 0; fm_col < features_matrix->cols; fm_col++) {
+            features_matrix->buffer[(ix * features_matrix->cols) + fm_col] =
+                features_matrix->buffer[(ix * features_matrix->cols) + fm_col] - mean_matrix.buffer[fm_col];
+        }
+    }
+
+    ret = numpy::pad_1d_symmetric(features_matrix, &vec_pad, pad_size, pad_size);
+    if (ret != EIDSP_OK) {
+        EIDSP_ERR(ret);
+    }
+
+    for (size_t ix = 0; ix < features_matrix->rows; ix++) {
+        // create a slice on the vec_pad
+        EI_DSP_MATRIX_B(window, win_size, vec_pad.cols, vec_pad.buffer + (ix * vec_pad.cols));
+        if (!window.buffer) {
+            EIDSP_ERR(EIDSP_OUT_OF_MEM);
+        }
+
+        if (variance_normalization == true) {
+            ret = numpy::std_axis0(&window, &window_variance);
+            if (ret != EIDSP_OK) {
+                EIDSP_ERR(ret);
+            }
+
+            features_buffer_ptr = &features_matrix->buffer[ix * vec_pad.cols];
+            for (size_t col = 0; col < vec_pad.cols; col++) {
+                *(features_buffer_ptr) = (*(features_buffer_ptr)) /
+                                         (window_variance.buffer[col] + 1e-10);
+                features_buffer_ptr++;
+            }
+        }
+    }
+
+    if (scale) {
+        ret = numpy::normalize(features_matrix);
+        if (ret != EIDSP_OK) {
+            EIDSP_ERR(ret);
+        }
+    }
+
+    return EIDSP_OK;
+}
+
+// Faixa de cepstros MFCC, com um deslocamento por coluna para a média não ser zero
+static void fill_mfcc(float* buffer, size_t rows, size_t cols) {
+    for (size_t row = 0; row < rows; row++) {
+        for (size_t col = 0; col < cols; col++) buffer[row * cols + col] = rand_float(-15.0f, 15.0f) + 3.0f * col;
+    }
+}
+
+static void compare(const char* caso, const matrix_t* got, const matrix_t* ref) {
+    for (size_t i = 0; i < got->rows * got->cols; i++) {
+        check(caso, got->rows, i, got->buffer[i], ref->buffer[i], TOLERANCIA);
+    }
+}
+
+static void test_casos() {
+    for (const Caso& caso : casos) {
+        matrix_t input(caso.rows, caso.cols), ref(caso.rows, caso.cols), got(caso.rows, caso.cols);
+        fill_mfcc(input.buffer, caso.rows, caso.cols);
+        for (bool variance : { false, true }) {
+            if (variance && caso.rows == 1) continue;
+            for (bool scale : { false, true }) {
+                memcpy(ref.buffer, input.buffer, caso.rows * caso.cols * sizeof(float));
+                memcpy(got.buffer, input.buffer, caso.rows * caso.cols * sizeof(float));
+                cmvnw_anterior(&ref, caso.win_size, variance, scale);
+                speechpy::processing::cmvnw(&got, caso.win_size, variance, scale);
+                compare(variance ? "cmvnw variância" : "cmvnw média", &got, &ref);
+            }
+        }
+    }
+}
+
+// Modo contínuo: cada fatia acrescenta 12 ou 13 linhas e a janela anda o mesmo tanto
+static void test_running() {
+    const size_t cols = 13;
+    const uint16_t win_size = 101;
+    std::vector<float> stream(STREAM_ROWS * cols);
+    fill_mfcc(stream.data(), STREAM_ROWS, cols);
+
+    speechpy::processing::cmvnw_running running;
+    running.reset(WINDOW_ROWS, cols);
+    matrix_t got(WINDOW_ROWS, cols), ref(WINDOW_ROWS, cols);
+
+    size_t fim = 0, fatia = 0;
+    while (fim < STREAM_ROWS) {
+        size_t novas = std::min(static_cast<size_t>(12 + (fatia++ % 2)), static_cast<size_t>(STREAM_ROWS) - fim);
+        running.push(stream.data() + fim * cols, novas);
+        fim += novas;
+        if (!running.is_ready()) continue;
+
+        const float* janela = stream.data() + (fim - WINDOW_ROWS) * cols;
+        memcpy(got.buffer, janela, WINDOW_ROWS * cols * sizeof(float));
+        memcpy(ref.buffer, janela, WINDOW_ROWS * cols * sizeof(float));
+        running.apply(&got, win_size, true, false);
+        cmvnw_anterior(&ref, win_size, true, false);
+        compare("cmvnw_running", &got, &ref);
+    }
+}
+
+static void bench() {
+    matrix_t input(50, 13), m(50, 13);
+    fill_mfcc(input.buffer, 50, 13);
+
+    printf("[INFO] cmvnw de uma janela de 1 s (50 x 13, janela 101, com variância):\n");
+    printf("  padding + janelas    %8.2f us\n", bench_us([&] {
+        memcpy(m.buffer, input.buffer, sizeof(float) * 50 * 13);
+        cmvnw_anterior(&m, 101, true, false);
+    }));
+    printf("  somas de prefixo     %8.2f us\n", bench_us([&] {
+        memcpy(m.buffer, input.buffer, sizeof(float) * 50 * 13);
+        speechpy::processing::cmvnw(&m, 101, true, false);
+    }));
+}
+
+int main() {
+    srand(3);
+    test_casos();
+    test_running();
+    int ret = report("cmvnw");
+    bench();
+    return ret;
+}
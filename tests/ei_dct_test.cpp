@@ -0,0 +1,91 @@
+/*
+*   Teste da DCT-II truncada com base em cache (numpy::dct2 com matriz de saída, ei_dct_basis_cache.h).
+*
+*   Compara com o caminho anterior do MFCC: numpy::dct2 no lugar, por linha, via FFT, com todos os
+*   coeficientes, e depois a cópia só dos num_cepstral primeiros. A base é um produto direto em vez
+*   da FFT, então a diferença é de arredondamento de float. Testa os tamanhos do MFCC do modelo
+*   (32 filtros, 13 coeficientes) e outros, com e sem normalização ortho, e mede o tempo por janela
+*   de 1 s (50 quadros).
+*
+*   No Pi:  cmake -DEI_DSP_TESTS=ON ... && make ei_dct_test && ./ei_dct_test
+*   No host, a partir da raiz do repositório:
+*       g++ -O2 -std=c++17 -I. -Iedge-impulse-sdk -Imodel-parameters -Itflite-model tests/ei_dct_test.cpp \
+*           edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp \
+*           edge-impulse-sdk/dsp/memory.cpp edge-impulse-sdk/porting/posix/debug_log.cpp \
+*           edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp -lpthread -o ei_dct_test
+*
+*   @return 0 se a DCT truncada ficou dentro da tolerância da DCT via FFT.
+*/
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "ei_dsp_test.h"
+
+#include <vector>
+
+using namespace ei;
+
+#define FRAMES          50                                  // Quadros de uma janela de 1 s
+#define TOLERANCIA      1e-5f                               // Erro aceito contra a DCT via FFT, relativo ao maior coeficiente da linha
+
+struct Caso {
+    size_t n;       // Filtros (entrada da DCT)
+    size_t k;       // Coeficientes mantidos
+};
+
+static const Caso casos[] = { { 32, 13 }, { 40, 13 }, { 26, 26 }, { 64, 20 }, { 16, 1 }, { 8, 8 } };
+// A DCT via FFT só aceita N par
+
+// Caminho anterior do MFCC: DCT completa no lugar (em completa, do tamanho de input) e cópia dos
+// k primeiros coeficientes
+static void dct_anterior(const matrix_t* input, matrix_t* completa, matrix_t* output, DCT_NORMALIZATION_MODE normalizacao) {
+    memcpy(completa->buffer, input->buffer, input->rows * input->cols * sizeof(float));
+    numpy::dct2(completa, normalizacao);
+    for (size_t row = 0; row < input->rows; row++) {
+        for (size_t i = 0; i < output->cols; i++) {
+            output->buffer[row * output->cols + i] = completa->buffer[row * completa->cols + i];
+        }
+    }
+}
+
+static float test_casos() {
+    float erro_max = 0.0f;
+    for (const Caso& caso : casos) {
+        for (DCT_NORMALIZATION_MODE normalizacao : { DCT_NORMALIZATION_NONE, DCT_NORMALIZATION_ORTHO }) {
+            matrix_t input(FRAMES, caso.n), completa(FRAMES, caso.n), ref(FRAMES, caso.k), got(FRAMES, caso.k);
+            // Faixa de um log-mel
+            for (size_t i = 0; i < FRAMES * caso.n; i++) input.buffer[i] = rand_float(-20.0f, 10.0f);
+
+            dct_anterior(&input, &completa, &ref, normalizacao);
+            numpy::dct2(&input, &got, normalizacao);
+            const char* nome = normalizacao == DCT_NORMALIZATION_ORTHO ? "dct2 ortho" : "dct2";
+            for (size_t row = 0; row < FRAMES; row++) {
+                // Os coeficientes pequenos vêm de cancelamento entre termos grandes: o erro é medido
+                // em relação ao maior coeficiente da linha
+                float escala = 1.0f;
+                for (size_t i = 0; i < caso.k; i++) escala = std::max(escala, fabsf(ref.buffer[row * caso.k + i]));
+                for (size_t i = row * caso.k; i < (row + 1) * caso.k; i++) {
+                    check(nome, caso.n, i, got.buffer[i] / escala, ref.buffer[i] / escala, TOLERANCIA);
+                    erro_max = std::max(erro_max, fabsf(got.buffer[i] - ref.buffer[i]) / escala);
+                }
+            }
+        }
+    }
+    return erro_max;
+}
+
+static void bench() {
+    matrix_t input(FRAMES, 32), completa(FRAMES, 32), output(FRAMES, 13);
+    for (size_t i = 0; i < FRAMES * 32; i++) input.buffer[i] = rand_float(-20.0f, 10.0f);
+
+    printf("[INFO] Cepstros de uma janela de 1 s (%d x 32 -> %d x 13):\n", FRAMES, FRAMES);
+    printf("  DCT via FFT + cópia  %8.2f us\n", bench_us([&] { dct_anterior(&input, &completa, &output, DCT_NORMALIZATION_ORTHO); }));
+    printf("  base em cache        %8.2f us\n", bench_us([&] { numpy::dct2(&input, &output, DCT_NORMALIZATION_ORTHO); }));
+}
+
+int main() {
+    srand(3);
+    float erro_max = test_casos();
+    printf("[INFO] Maior diferença relativa ao maior coeficiente da linha: %.3g\n", erro_max);
+    int ret = report("DCT-II truncada");
+    bench();
+    return ret;
+}
@@ -0,0 +1,47 @@
+/*
+*   Funções comuns dos testes de equivalência do DSP (tests/ei_*_test.cpp): números aleatórios,
+*   comparação com tolerância e medida de tempo. Cada teste compara um caminho do SDK com o código
+*   que ele substituiu, copiado para o próprio teste, e imprime os tempos dos dois.
+*/
+#ifndef EI_DSP_TEST_H
+#define EI_DSP_TEST_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#define BENCH_RUNS      200                                 // Repetições por medida de tempo
+
+static int falhas = 0;
+
+static float rand_float(float min, float max) {
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+// Erro relativo aceito; 0 exige resultado bit a bit igual ao código anterior
+static void check(const char* caso, size_t n, size_t i, float got, float ref, float tol) {
+    if (tol == 0.0f ? got == ref : fabsf(got - ref) <= tol * (1.0f + fabsf(ref))) return;
+    if (falhas++ < 20) {
+        printf("[ERRO] %s n=%zu i=%zu: %.9g != %.9g\n", caso, n, i, got, ref);
+    }
+}
+
+template <typename F>
+static double bench_us(F f) {
+    auto inicio = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_RUNS; i++) f();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count() / BENCH_RUNS;
+}
+
+// Resultado final do teste, no formato do ei_neon_dsp_test
+static int report(const char* nome) {
+    if (falhas) {
+        printf("[ERRO] %s: %d valores fora da tolerância.\n", nome, falhas);
+        return 1;
+    }
+    printf("[INFO] %s: mesmo resultado do código anterior, dentro da tolerância.\n", nome);
+    return 0;
+}
+
+#endif // EI_DSP_TEST_H
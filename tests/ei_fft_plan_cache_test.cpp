@@ -0,0 +1,118 @@
+/*
+*   Teste do cache de planos KissFFT (edge-impulse-sdk/dsp/ei_fft_plan_cache.h).
+*
+*   Compara numpy::rfft, que usa os planos do cache, com o caminho anterior de software_rfft, que
+*   criava e liberava um plano com kiss_fftr_alloc a cada FFT. Os twiddles são os mesmos, então a
+*   saída tem que ser bit a bit igual, inclusive com várias threads usando o mesmo tamanho ao mesmo
+*   tempo. Mede o tempo por quadro de 256 pontos e por janela de 1 s (50 quadros).
+*
+*   No Pi:  cmake -DEI_DSP_TESTS=ON ... && make ei_fft_plan_cache_test && ./ei_fft_plan_cache_test
+*   No host, a partir da raiz do repositório:
+*       g++ -O2 -std=c++17 -I. -Iedge-impulse-sdk -Imodel-parameters -Itflite-model tests/ei_fft_plan_cache_test.cpp \
+*           edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp \
+*           edge-impulse-sdk/dsp/memory.cpp edge-impulse-sdk/porting/posix/debug_log.cpp \
+*           edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp -lpthread -o ei_fft_plan_cache_test
+*
+*   @return 0 se o cache deu o mesmo resultado que o plano por chamada.
+*/
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "ei_dsp_test.h"
+
+#include <thread>
+#include <vector>
+
+using namespace ei;
+
+#define MAX_FFT         1024                                // Maior FFT testada
+#define THREADS         4                                   // Threads usando o mesmo tamanho de plano
+#define THREAD_RUNS     2000                                // FFTs por thread
+
+static const size_t sizes[] = { 32, 64, 128, 256, 512, MAX_FFT };
+
+// software_rfft antes do cache: um plano novo por FFT
+static int rfft_sem_cache(const float* src, fft_complex_t* output, size_t n_fft) {
+    std::vector<float> input(src, src + n_fft);
+    size_t kiss_fftr_mem_length;
+    kiss_fftr_cfg cfg = kiss_fftr_alloc(n_fft, 0, NULL, NULL, &kiss_fftr_mem_length);
+    if (!cfg) return EIDSP_OUT_OF_MEM;
+    kiss_fftr(cfg, input.data(), (kiss_fft_cpx*)output);
+    ei_free(cfg);
+    return EIDSP_OK;
+}
+
+static void compare(const char* caso, size_t n, const fft_complex_t* got, const fft_complex_t* ref) {
+    for (size_t i = 0; i < n / 2 + 1; i++) {
+        check(caso, n, i, got[i].r, ref[i].r, 0.0f);
+        check(caso, n, i, got[i].i, ref[i].i, 0.0f);
+    }
+}
+
+static void test_sizes() {
+    std::vector<float> input(MAX_FFT);
+    std::vector<fft_complex_t> ref(MAX_FFT / 2 + 1), got(MAX_FFT / 2 + 1);
+
+    for (size_t n : sizes) {
+        for (size_t i = 0; i < n; i++) input[i] = rand_float(-1.0f, 1.0f);
+        rfft_sem_cache(input.data(), ref.data(), n);
+        // Duas vezes: a primeira cria o plano, a segunda o reaproveita
+        for (int vez = 0; vez < 2; vez++) {
+            numpy::rfft(input.data(), n, got.data(), n / 2 + 1, n);
+            compare("rfft", n, got.data(), ref.data());
+        }
+    }
+}
+
+static void test_threads() {
+    const size_t n = 256;
+    std::vector<std::vector<float>> inputs(THREADS, std::vector<float>(n));
+    std::vector<std::vector<fft_complex_t>> refs(THREADS, std::vector<fft_complex_t>(n / 2 + 1));
+    for (int t = 0; t < THREADS; t++) {
+        for (size_t i = 0; i < n; i++) inputs[t][i] = rand_float(-1.0f, 1.0f);
+        rfft_sem_cache(inputs[t].data(), refs[t].data(), n);
+    }
+
+    std::vector<int> diferentes(THREADS, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t] {
+            std::vector<fft_complex_t> got(n / 2 + 1);
+            for (int run = 0; run < THREAD_RUNS; run++) {
+                numpy::rfft(inputs[t].data(), n, got.data(), n / 2 + 1, n);
+                for (size_t i = 0; i < n / 2 + 1; i++) {
+                    diferentes[t] += (got[i].r != refs[t][i].r) || (got[i].i != refs[t][i].i);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (int t = 0; t < THREADS; t++) {
+        if (diferentes[t]) {
+            printf("[ERRO] thread %d: %d bins diferentes\n", t, diferentes[t]);
+            falhas++;
+        }
+    }
+}
+
+static void bench() {
+    const size_t n = 256;
+    std::vector<float> input(n);
+    std::vector<fft_complex_t> output(n / 2 + 1);
+    for (size_t i = 0; i < n; i++) input[i] = rand_float(-1.0f, 1.0f);
+
+    printf("[INFO] rfft de %zu pontos:\n", n);
+    printf("  plano por chamada   %8.2f us/quadro, %8.2f us/janela\n",
+           bench_us([&] { rfft_sem_cache(input.data(), output.data(), n); }),
+           bench_us([&] { for (int f = 0; f < 50; f++) rfft_sem_cache(input.data(), output.data(), n); }));
+    printf("  plano do cache      %8.2f us/quadro, %8.2f us/janela\n",
+           bench_us([&] { numpy::rfft(input.data(), n, output.data(), n / 2 + 1, n); }),
+           bench_us([&] { for (int f = 0; f < 50; f++) numpy::rfft(input.data(), n, output.data(), n / 2 + 1, n); }));
+}
+
+int main() {
+    srand(3);
+    test_sizes();
+    test_threads();
+    int ret = report("Cache de planos KissFFT");
+    bench();
+    return ret;
+}
@@ -0,0 +1,186 @@
+/*
+*   Teste do banco de filtros Mel esparso em cache (speechpy/mel_filterbank_cache.hpp).
+*
+*   Compara com o código anterior de speechpy::feature::mfe, copiado abaixo, que recalculava os
+*   pontos Mel e os bins a cada chamada e os pesos triangulares a cada quadro. Sem NEON a ordem das
+*   somas é a mesma e o resultado tem que ser bit a bit igual; com NEON o produto escalar usa somas
+*   parciais e a diferença é de arredondamento. Testa configurações v2/v3/v4 (inclusive a
+*   peculiaridade do max_bin antes da v4) e mede o tempo por janela de 1 s (50 quadros) e do mfe.
+*
+*   No Pi:  cmake -DEI_DSP_TESTS=ON ... && make ei_mel_filterbank_test && ./ei_mel_filterbank_test
+*   No host, a partir da raiz do repositório:
+*       g++ -O2 -std=c++17 -I. -Iedge-impulse-sdk -Imodel-parameters -Itflite-model tests/ei_mel_filterbank_test.cpp \
+*           edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp \
+*           edge-impulse-sdk/dsp/memory.cpp edge-impulse-sdk/porting/posix/debug_log.cpp \
+*           edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp -lpthread -o ei_mel_filterbank_test
+*
+*   @return 0 se o banco esparso deu o mesmo resultado que o denso.
+*/
+#include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+#include "ei_dsp_test.h"
+
+#include <vector>
+
+using namespace ei;
+
+#define FRAMES          50                                  // Quadros de uma janela de 1 s
+#define TOLERANCIA      (EIDSP_USE_NEON ? 1e-5f : 0.0f)     // Só o NEON muda a ordem das somas
+
+struct Caso {
+    uint32_t sampling_frequency;
+    uint16_t num_filters;
+    uint16_t fft_length;
+    uint32_t low_frequency;
+    uint32_t high_frequency;
+    uint16_t version;
+};
+
+static const Caso casos[] = {
+    { 16000, 32, 256, 0, 8000, 4 },     // MFCC do modelo de wake word
+    { 16000, 32, 256, 0, 8000, 3 },
+    { 16000, 40, 512, 80, 7600, 4 },
+    { 16000, 40, 512, 300, 8000, 2 },
+    { 8000, 20, 256, 0, 4000, 3 },
+    { 44100, 64, 1024, 20, 22050, 4 },
+};
+
+// Filtros de mfe antes do cache: pontos Mel e bins recalculados a cada chamada
+static std::vector<uint16_t> bins_anteriores(const Caso& c) {
+    const size_t power_spectrum_frame_size = (c.fft_length / 2 + 1);
+    const int MELS_SIZE = c.num_filters + 2;
+    std::vector<float> mels(MELS_SIZE);
+    std::vector<uint16_t> bins(MELS_SIZE);
+
+    numpy::linspace(
+        speechpy::functions::frequency_to_mel(static_cast<float>(c.low_frequency)),
+        speechpy::functions::frequency_to_mel(static_cast<float>(c.high_frequency)),
+        c.num_filters + 2,
+        mels.data());
+
+    uint16_t max_bin = c.version >= 4 ? c.fft_length : power_spectrum_frame_size; // preserve a bug in v<4
+    // go to -1 size b/c special handling, see after
+    for (uint16_t ix = 0; ix < MELS_SIZE-1; ix++) {
+        mels[ix] = speechpy::functions::mel_to_frequency(mels[ix]);
+        if (mels[ix] < c.low_frequency) {
+            mels[ix] = c.low_frequency;
+        }
+        if (mels[ix] > c.high_frequency) {
+            mels[ix] = c.high_frequency;
+        }
+        bins[ix] = speechpy::feature::get_fft_bin_from_hertz(max_bin, mels[ix], c.sampling_frequency);
+    }
+
+    mels[MELS_SIZE-1] = speechpy::functions::mel_to_frequency(mels[MELS_SIZE-1]);
+    if (mels[MELS_SIZE-1] > c.high_frequency) {
+        mels[MELS_SIZE-1] = c.high_frequency;
+    }
+    mels[MELS_SIZE-1] -= 0.001;
+    bins[MELS_SIZE-1] = speechpy::feature::get_fft_bin_from_hertz(max_bin, mels[MELS_SIZE-1], c.sampling_frequency);
+    return bins;
+}
+
+// Laço denso anterior, com os pesos triangulares calculados a cada quadro
+static void aplica_anterior(const uint16_t* bins, uint16_t num_filters, const float* power_spectrum, float* row_ptr) {
+    for (size_t i = 0; i < num_filters; i++) {
+        size_t left = bins[i];
+        size_t middle = bins[i+1];
+        size_t right = bins[i+2];
+
+        // middle always has weight of 1.0
+        // since we skip left and right, if left = middle we need to handle that
+        row_ptr[i] = power_spectrum[middle];
+
+        for (size_t bin = left+1; bin < right; bin++) {
+            if (bin < middle) {
+                row_ptr[i] +=
+                    ((static_cast<float>(bin) - left) / (middle - left)) * // weight *
+                    power_spectrum[bin];
+            }
+            // intentionally skip middle, handled above
+            if (bin > middle) {
+                row_ptr[i] +=
+                    ((right - static_cast<float>(bin)) / (right - middle)) * // weight *
+                    power_spectrum[bin];
+            }
+        }
+    }
+}
+
+static std::vector<float> espectros(size_t fft_length) {
+    std::vector<float> power(FRAMES * (fft_length / 2 + 1));
+    for (float& p : power) p = rand_float(0.0f, 50.0f);
+    return power;
+}
+
+static void test_casos() {
+    for (const Caso& c : casos) {
+        const size_t bins_por_quadro = c.fft_length / 2 + 1;
+        std::vector<float> power = espectros(c.fft_length);
+        std::vector<float> ref(FRAMES * c.num_filters), got(FRAMES * c.num_filters);
+
+        std::vector<uint16_t> bins = bins_anteriores(c);
+        const speechpy::mel_filterbank_t* filterbank = speechpy::mel_filterbank_cache::get(
+            c.sampling_frequency, c.num_filters, c.fft_length, c.low_frequency, c.high_frequency, c.version);
+        if (!filterbank) {
+            printf("[ERRO] Sem memória para o banco de filtros\n");
+            falhas++;
+            return;
+        }
+
+        for (size_t f = 0; f < FRAMES; f++) {
+            aplica_anterior(bins.data(), c.num_filters, power.data() + f * bins_por_quadro, ref.data() + f * c.num_filters);
+            speechpy::mel_filterbank_cache::apply(filterbank, power.data() + f * bins_por_quadro, got.data() + f * c.num_filters);
+        }
+        for (size_t i = 0; i < ref.size(); i++) {
+            check("filtros Mel", c.fft_length, i, got[i], ref[i], TOLERANCIA);
+        }
+    }
+}
+
+static float sinal_buffer[16000];
+
+static int get_sinal(size_t offset, size_t length, float* out) {
+    memcpy(out, sinal_buffer + offset, length * sizeof(float));
+    return 0;
+}
+
+static void bench() {
+    const Caso& c = casos[0];
+    const size_t bins_por_quadro = c.fft_length / 2 + 1;
+    std::vector<float> power = espectros(c.fft_length);
+    std::vector<float> out(FRAMES * c.num_filters);
+
+    printf("[INFO] Banco de filtros Mel de uma janela de 1 s (%d quadros, %u filtros, FFT de %u):\n",
+           FRAMES, c.num_filters, c.fft_length);
+    printf("  denso, bins por chamada  %8.2f us\n", bench_us([&] {
+        std::vector<uint16_t> bins = bins_anteriores(c);
+        for (size_t f = 0; f < FRAMES; f++) {
+            aplica_anterior(bins.data(), c.num_filters, power.data() + f * bins_por_quadro, out.data() + f * c.num_filters);
+        }
+    }));
+    printf("  esparso em cache         %8.2f us\n", bench_us([&] {
+        const speechpy::mel_filterbank_t* filterbank = speechpy::mel_filterbank_cache::get(
+            c.sampling_frequency, c.num_filters, c.fft_length, c.low_frequency, c.high_frequency, c.version);
+        for (size_t f = 0; f < FRAMES; f++) {
+            speechpy::mel_filterbank_cache::apply(filterbank, power.data() + f * bins_por_quadro, out.data() + f * c.num_filters);
+        }
+    }));
+
+    for (size_t i = 0; i < 16000; i++) sinal_buffer[i] = sinf(i * 0.05f) * 0.3f + rand_float(-0.05f, 0.05f);
+    signal_t sinal;
+    sinal.total_length = 16000;
+    sinal.get_data = get_sinal;
+    matrix_t features(FRAMES, c.num_filters), energias(FRAMES, 1);
+    printf("  mfe completo             %8.2f us\n", bench_us([&] {
+        speechpy::feature::mfe(&features, &energias, &sinal, c.sampling_frequency, 0.02f, 0.02f,
+            c.num_filters, c.fft_length, 0, 0, c.version);
+    }));
+}
+
+int main() {
+    srand(3);
+    test_casos();
+    int ret = report("Banco de filtros Mel");
+    bench();
+    return ret;
+}
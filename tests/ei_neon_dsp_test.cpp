@@ -0,0 +1,183 @@
+/*
+*   Teste dos kernels ei::simd (edge-impulse-sdk/dsp/dsp_engines/ei_neon_dsp.h).
+*
+*   Compara cada kernel com o laço escalar que ele substitui, para vários tamanhos (inclusive os
+*   restos que não fecham um vetor NEON), e mede o tempo por janela de 1 s do front-end MFCC.
+*   Compilado com EIDSP_USE_NEON=1 no Raspberry Pi testa os corpos NEON; no host testa o caminho escalar.
+*
+*   No Pi:  cmake -DEI_DSP_TESTS=ON ... && make ei_neon_dsp_test && ./ei_neon_dsp_test
+*   No host, a partir da raiz do repositório:
+*       g++ -O2 -std=c++17 -I. -Iedge-impulse-sdk -Imodel-parameters -Itflite-model tests/ei_neon_dsp_test.cpp \
+*           edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp \
+*           edge-impulse-sdk/dsp/memory.cpp edge-impulse-sdk/porting/posix/debug_log.cpp \
+*           edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp -lpthread -o ei_neon_dsp_test
+*
+*   @return 0 se todos os kernels ficaram dentro da tolerância.
+*/
+#include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace ei;
+
+#define MAX_N           1024                                // Maior vetor testado
+#define WINDOW_SAMPLES  16000                               // Janela de 1 s a 16 kHz
+#define BENCH_RUNS      200                                 // Repetições por medida de tempo
+
+static const size_t sizes[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 129, 257, MAX_N };
+static int falhas = 0;
+
+static float rand_float(float min, float max) {
+    return min + (max - min) * (rand() / static_cast<float>(RAND_MAX));
+}
+
+// Erro relativo aceito; 0 exige resultado bit a bit igual ao laço escalar
+static void check(const char* kernel, size_t n, size_t i, float got, float ref, float tol) {
+    if (tol == 0.0f ? got == ref : fabsf(got - ref) <= tol * (1.0f + fabsf(ref))) return;
+    if (falhas++ < 20) {
+        printf("[ERRO] %s n=%zu i=%zu: %.9g != %.9g\n", kernel, n, i, got, ref);
+    }
+}
+
+static void test_kernels() {
+    std::vector<float> a(MAX_N), b(MAX_N), c(MAX_N), ref(MAX_N);
+    std::vector<int16_t> s(MAX_N);
+    std::vector<int8_t> q(MAX_N);
+    std::vector<fft_complex_t> cx(MAX_N);
+
+    for (size_t n : sizes) {
+        for (size_t i = 0; i < n; i++) {
+            a[i] = rand_float(1e-6f, 3e4f);
+            b[i] = rand_float(-40.0f, 40.0f);
+            s[i] = static_cast<int16_t>(rand() - RAND_MAX / 2);
+            cx[i].r = rand_float(-300.0f, 300.0f);
+            cx[i].i = rand_float(-300.0f, 300.0f);
+        }
+
+        simd::int16_to_float(s.data(), c.data(), n, 1.0f / 32768.0f);
+        for (size_t i = 0; i < n; i++) check("int16_to_float", n, i, c[i], static_cast<float>(s[i]) * (1.0f / 32768.0f), 0.0f);
+
+        std::copy(b.begin(), b.end(), c.begin());
+        simd::preemphasis(c.data(), n, 0.5f, 0.98f);
+        for (size_t i = 0; i < n; i++) check("preemphasis", n, i, c[i], b[i] - 0.98f * (i ? b[i - 1] : 0.5f), 0.0f);
+
+        simd::power_from_complex(cx.data(), c.data(), n, 1.0f / 256.0f);
+        for (size_t i = 0; i < n; i++) {
+            check("power_from_complex", n, i, c[i], (1.0f / 256.0f) * ((cx[i].r * cx[i].r) + (cx[i].i * cx[i].i)), 0.0f);
+        }
+
+        // A soma em quatro parciais muda a ordem das somas: tolerância relativa à soma dos módulos
+        float dot_ref = 1.0f, dot_abs = 1.0f;
+        for (size_t i = 0; i < n; i++) {
+            dot_ref += a[i] * b[i];
+            dot_abs += fabsf(a[i] * b[i]);
+        }
+        float dot = simd::dot(a.data(), b.data(), n, 1.0f);
+        if (fabsf(dot - dot_ref) > 1e-5f * dot_abs) check("dot", n, 0, dot, dot_ref, 0.0f);
+
+        std::copy(a.begin(), a.end(), c.begin());
+        simd::subtract(c.data(), b.data(), n);
+        for (size_t i = 0; i < n; i++) check("subtract", n, i, c[i], a[i] - b[i], 0.0f);
+
+        std::copy(a.begin(), a.end(), c.begin());
+        simd::log(c.data(), n);
+        for (size_t i = 0; i < n; i++) check("log", n, i, c[i], numpy::log(a[i]), 0.0f);
+
+        // Inclui valores fora da faixa do int8 para testar a saturação
+        for (size_t i = 0; i < n; i++) c[i] = rand_float(-2.0f, 2.0f);
+        simd::quantize_i8(c.data(), q.data(), n, 0.0078125f, -3);
+        for (size_t i = 0; i < n; i++) {
+            int32_t v = static_cast<int32_t>(roundf(c[i] / 0.0078125f)) - 3;
+            v = v < -128 ? -128 : (v > 127 ? 127 : v);
+            check("quantize_i8", n, i, q[i], static_cast<float>(v), 0.0f);
+        }
+    }
+}
+
+static int16_t raw[WINDOW_SAMPLES];
+static signal_t raw_signal;
+static std::unique_ptr<class speechpy::processing::preemphasis> pre;
+
+static int get_raw(size_t offset, size_t length, float* out) {
+    simd::int16_to_float(raw + offset, out, length, 1.0f / 32768.0f);
+    return 0;
+}
+
+static int get_pre(size_t offset, size_t length, float* out) {
+    return pre->get_data(offset, length, out);
+}
+
+// MFCC + CMVN de uma janela de 1 s com os parâmetros do modelo de wake word
+static void mfcc_window(matrix_t* out) {
+    raw_signal.total_length = WINDOW_SAMPLES;
+    raw_signal.get_data = get_raw;
+    pre.reset(new class speechpy::processing::preemphasis(&raw_signal, 1, 0.98f, false));
+
+    signal_t pre_signal;
+    pre_signal.total_length = WINDOW_SAMPLES;
+    pre_signal.get_data = get_pre;
+    speechpy::feature::mfcc(out, &pre_signal, WINDOW_SAMPLES, 0.02f, 0.02f, 13, 32, 256, 0, 0, true, 4);
+    speechpy::processing::cmvnw(out, 101, true, false);
+}
+
+template <typename F>
+static double bench_us(F f) {
+    auto inicio = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_RUNS; i++) f();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count() / BENCH_RUNS;
+}
+
+static void bench() {
+    for (int i = 0; i < WINDOW_SAMPLES; i++) {
+        raw[i] = static_cast<int16_t>(sinf(i * 0.05f) * 3000 + (rand() % 2000 - 1000));
+    }
+
+    // Quantidades de uma janela: 50 quadros de 320 amostras, FFT de 256, 32 filtros, 13 coeficientes
+    std::vector<float> wave(WINDOW_SAMPLES), frames(50 * 129), mel(50 * 32), features(50 * 13), mean(13, 0.5f);
+    std::vector<fft_complex_t> spectrum(50 * 129);
+    std::vector<int8_t> tensor(50 * 13);
+    for (size_t i = 0; i < spectrum.size(); i++) {
+        spectrum[i].r = rand_float(-300.0f, 300.0f);
+        spectrum[i].i = rand_float(-300.0f, 300.0f);
+    }
+    for (size_t i = 0; i < mel.size(); i++) mel[i] = rand_float(1e-6f, 3e4f);
+    volatile float sink = 0.0f;
+
+    printf("[INFO] Tempo por janela de 1 s (%s):\n", EIDSP_USE_NEON ? "NEON" : "escalar");
+    printf("  int16_to_float      %8.2f us\n", bench_us([&] { simd::int16_to_float(raw, wave.data(), WINDOW_SAMPLES, 1.0f / 32768.0f); }));
+    printf("  preemphasis         %8.2f us\n", bench_us([&] { simd::preemphasis(wave.data(), WINDOW_SAMPLES, 0.0f, 0.98f); }));
+    printf("  power_from_complex  %8.2f us\n", bench_us([&] { simd::power_from_complex(spectrum.data(), frames.data(), frames.size(), 1.0f / 256.0f); }));
+    printf("  dot (filtros mel)   %8.2f us\n", bench_us([&] {
+        for (size_t f = 0; f < 50 * 32; f++) sink = sink + simd::dot(frames.data() + (f % 50) * 129, frames.data() + (f % 97), 12);
+    }));
+    printf("  log                 %8.2f us\n", bench_us([&] {
+        std::vector<float> m(mel);
+        simd::log(m.data(), m.size());
+    }));
+    printf("  subtract (CMVN)     %8.2f us\n", bench_us([&] {
+        for (size_t row = 0; row < 50; row++) simd::subtract(features.data() + row * 13, mean.data(), 13);
+    }));
+    printf("  quantize_i8         %8.2f us\n", bench_us([&] { simd::quantize_i8(features.data(), tensor.data(), features.size(), 0.05f, 0); }));
+
+    matrix_t out(50, 13);
+    mfcc_window(&out);
+    printf("  MFCC + CMVN         %8.2f us\n", bench_us([&] { mfcc_window(&out); }));
+}
+
+int main() {
+    srand(3);
+    test_kernels();
+    if (falhas) {
+        printf("[ERRO] %d valores fora da tolerância.\n", falhas);
+    } else {
+        printf("[INFO] Kernels ei::simd (%s) iguais ao laço escalar.\n", EIDSP_USE_NEON ? "NEON" : "escalar");
+    }
+    bench();
+    return falhas ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+/*
+*   Teste do espectro de potência com workspace (numpy::power_spectrum com fft_workspace).
+*
+*   Compara com o caminho anterior, copiado abaixo: rfft com saída em módulo, que alocava um buffer
+*   complexo e uma cópia da entrada a cada quadro e tirava sqrt(r*r + i*i), elevado de novo ao
+*   quadrado e escalado por 1/N. O novo calcula (r*r + i*i) / N direto da saída complexa, então a
+*   diferença é o arredondamento da ida e volta pela raiz. Testa quadros maiores, iguais e menores
+*   que a FFT (truncamento e zero padding) e mede o tempo por janela de 1 s (50 quadros).
+*
+*   No Pi:  cmake -DEI_DSP_TESTS=ON ... && make ei_power_spectrum_test && ./ei_power_spectrum_test
+*   No host, a partir da raiz do repositório:
+*       g++ -O2 -std=c++17 -I. -Iedge-impulse-sdk -Imodel-parameters -Itflite-model tests/ei_power_spectrum_test.cpp \
+*           edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp \
+*           edge-impulse-sdk/dsp/memory.cpp edge-impulse-sdk/porting/posix/debug_log.cpp \
+*           edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp -lpthread -o ei_power_spectrum_test
+*
+*   @return 0 se o espectro com workspace ficou dentro da tolerância do anterior.
+*/
+#include "edge-impulse-sdk/dsp/numpy.hpp"
+#include "ei_dsp_test.h"
+
+#include <vector>
+
+using namespace ei;
+
+#define FRAMES          50                                  // Quadros de uma janela de 1 s
+#define TOLERANCIA      1e-6f                               // Erro relativo aceito (ida e volta pela raiz)
+
+struct Caso {
+    size_t frame_size;
+    uint16_t fft_points;
+};
+
+static const Caso casos[] = { { 320, 256 }, { 256, 256 }, { 200, 256 }, { 320, 512 }, { 480, 512 }, { 64, 64 } };
+
+// power_spectrum antes do workspace: módulo da rfft elevado ao quadrado
+static int power_spectrum_anterior(float* frame, size_t frame_size, float* out_buffer, size_t out_buffer_size,
+    uint16_t fft_points)
+{
+    if (out_buffer_size != static_cast<size_t>(fft_points / 2 + 1)) {
+        EIDSP_ERR(EIDSP_MATRIX_SIZE_MISMATCH);
+    }
+
+    int r = numpy::rfft(frame, frame_size, out_buffer, out_buffer_size, fft_points);
+    if (r != EIDSP_OK) {
+        return r;
+    }
+
+    const float scale = static_cast<float>(1.0 / static_cast<float>(fft_points));
+    for (size_t ix = 0; ix < out_buffer_size; ix++) {
+        out_buffer[ix] = scale * (out_buffer[ix] * out_buffer[ix]);
+    }
+
+    return EIDSP_OK;
+}
+
+static void test_casos() {
+    for (const Caso& c : casos) {
+        const size_t bins = c.fft_points / 2 + 1;
+        std::vector<float> frames(FRAMES * c.frame_size), ref(bins), got(bins);
+        for (float& x : frames) x = rand_float(-1.0f, 1.0f);
+
+        fft_workspace workspace(c.fft_points);
+        for (size_t f = 0; f < FRAMES; f++) {
+            float* frame = frames.data() + f * c.frame_size;
+            power_spectrum_anterior(frame, c.frame_size, ref.data(), bins, c.fft_points);
+            numpy::power_spectrum(frame, c.frame_size, got.data(), bins, c.fft_points, &workspace);
+            for (size_t i = 0; i < bins; i++) check("power_spectrum", c.fft_points, f * bins + i, got[i], ref[i], TOLERANCIA);
+
+            // A versão sem workspace cria um por chamada e tem que dar o mesmo resultado
+            numpy::power_spectrum(frame, c.frame_size, ref.data(), bins, c.fft_points);
+            for (size_t i = 0; i < bins; i++) check("power_spectrum sem workspace", c.fft_points, f * bins + i, ref[i], got[i], 0.0f);
+        }
+    }
+}
+
+static void bench() {
+    const size_t frame_size = 320;
+    const uint16_t fft_points = 256;
+    const size_t bins = fft_points / 2 + 1;
+    std::vector<float> frames(FRAMES * frame_size), out(FRAMES * bins);
+    for (float& x : frames) x = rand_float(-1.0f, 1.0f);
+    fft_workspace workspace(fft_points);
+
+    printf("[INFO] Espectro de potência de uma janela de 1 s (%d quadros de %zu, FFT de %u):\n",
+           FRAMES, frame_size, fft_points);
+    printf("  módulo ao quadrado     %8.2f us\n", bench_us([&] {
+        for (size_t f = 0; f < FRAMES; f++) {
+            power_spectrum_anterior(frames.data() + f * frame_size, frame_size, out.data() + f * bins, bins, fft_points);
+        }
+    }));
+    printf("  complexo + workspace   %8.2f us\n", bench_us([&] {
+        for (size_t f = 0; f < FRAMES; f++) {
+            numpy::power_spectrum(frames.data() + f * frame_size, frame_size, out.data() + f * bins, bins, fft_points, &workspace);
+        }
+    }));
+}
+
+int main() {
+    srand(3);
+    test_casos();
+    int ret = report("Espectro de potência");
+    bench();
+    return ret;
+}
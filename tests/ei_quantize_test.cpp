@@ -0,0 +1,179 @@
+/*
+*   Teste da quantização das features MFCC para o tensor int8 do modelo de wake word.
+*
+*   Para cada janela de 1 s (de gravações WAV passadas como argumento, ou de sinais sintéticos):
+*     - calcula MFCC + CMVN em float, como o impulse;
+*     - quantiza com o laço original de fill_input_tensor_from_matrix (pre_cast_quantize) e com
+*       ei::simd::quantize_i8, e exige o mesmo tensor int8;
+*     - mede o erro do tensor int8 contra as features float e quantos valores saturam;
+*     - estima o limite inferior de erro de um front-end q15: arredonda as features para Q4.11
+*       (faixa de ±16, as features normalizadas passam de ±1) antes de quantizar e conta quantas
+*       entradas do tensor mudam. Um MFCC inteiro em q15 só pode errar mais que isso.
+*   Também mede o tempo e o pico de memória do DSP (EIDSP_TRACK_ALLOCATIONS) por inferência.
+*
+*   No Pi:  cmake -DEI_DSP_TESTS=ON ... && make ei_quantize_test && ./ei_quantize_test [clip.wav ...]
+*   No host, a partir da raiz do repositório:
+*       g++ -O2 -std=c++17 -I. -Iedge-impulse-sdk -Imodel-parameters -Itflite-model tests/ei_quantize_test.cpp \
+*           edge-impulse-sdk/dsp/kissfft/kiss_fft.cpp edge-impulse-sdk/dsp/kissfft/kiss_fftr.cpp \
+*           edge-impulse-sdk/dsp/memory.cpp edge-impulse-sdk/porting/posix/debug_log.cpp \
+*           edge-impulse-sdk/porting/posix/ei_classifier_porting.cpp -lpthread -o ei_quantize_test
+*
+*   @return 0 se quantize_i8 gerou o mesmo tensor que o laço original em todas as janelas.
+*/
+#define EIDSP_TRACK_ALLOCATIONS 1
+#define EIDSP_PRINT_ALLOCATIONS 0
+#include "edge-impulse-sdk/dsp/speechpy/speechpy.hpp"
+#include "edge-impulse-sdk/classifier/ei_quantize.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace ei;
+
+#define WINDOW_SAMPLES  16000                               // Janela de 1 s a 16 kHz
+#define WAV_HEADER      44                                  // Cabeçalho PCM 16 bits mono
+#define FEATURES        (50 * 13)                           // 50 quadros x 13 coeficientes
+#define SYNTH_WINDOWS   20                                  // Janelas sintéticas sem WAV
+#define BENCH_RUNS      200                                 // Repetições por medida de tempo
+#define Q11_ONE         2048.0f                             // 1.0 em Q4.11
+
+// Parâmetros de entrada do modelo (tflite-model/tflite_learn_5_compiled.cpp, quant0)
+static const float input_scale = 0.050396781414747238f;
+static const int32_t input_zero_point = 0;
+
+static int16_t raw[WINDOW_SAMPLES];
+static signal_t raw_signal;
+static std::unique_ptr<class speechpy::processing::preemphasis> pre;
+
+static int get_raw(size_t offset, size_t length, float* out) {
+    simd::int16_to_float(raw + offset, out, length, 1.0f / 32768.0f);
+    return 0;
+}
+
+static int get_pre(size_t offset, size_t length, float* out) {
+    return pre->get_data(offset, length, out);
+}
+
+// MFCC + CMVN de uma janela de 1 s com os parâmetros do modelo de wake word
+static void mfcc_window(matrix_t* out) {
+    raw_signal.total_length = WINDOW_SAMPLES;
+    raw_signal.get_data = get_raw;
+    pre.reset(new class speechpy::processing::preemphasis(&raw_signal, 1, 0.98f, false));
+
+    signal_t pre_signal;
+    pre_signal.total_length = WINDOW_SAMPLES;
+    pre_signal.get_data = get_pre;
+    speechpy::feature::mfcc(out, &pre_signal, WINDOW_SAMPLES, 0.02f, 0.02f, 13, 32, 256, 0, 0, true, 4);
+    speechpy::processing::cmvnw(out, 101, true, false);
+}
+
+// Laço que fill_input_tensor_from_matrix usava antes de quantize_i8
+static void quantize_loop(const float* in, int8_t* out, size_t n) {
+    for (size_t ix = 0; ix < n; ix++) {
+        out[ix] = static_cast<int8_t>(pre_cast_quantize(in[ix], input_scale, input_zero_point, true));
+    }
+}
+
+template <typename F>
+static double bench_us(F f) {
+    auto inicio = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_RUNS; i++) f();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count() / BENCH_RUNS;
+}
+
+static std::vector<std::vector<int16_t>> janelas;
+
+static bool read_wav(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, WAV_HEADER, SEEK_SET);
+    std::vector<int16_t> janela(WINDOW_SAMPLES);
+    while (fread(janela.data(), sizeof(int16_t), WINDOW_SAMPLES, f) == WINDOW_SAMPLES) {
+        janelas.push_back(janela);
+    }
+    fclose(f);
+    return true;
+}
+
+static void synth_windows() {
+    for (int w = 0; w < SYNTH_WINDOWS; w++) {
+        std::vector<int16_t> janela(WINDOW_SAMPLES);
+        float freq = 0.01f + 0.01f * w, amp = 500.0f + 800.0f * (w % 8);
+        for (int i = 0; i < WINDOW_SAMPLES; i++) {
+            janela[i] = static_cast<int16_t>(sinf(i * freq) * amp + (rand() % 2000 - 1000));
+        }
+        janelas.push_back(janela);
+    }
+}
+
+int main(int argc, char** argv) {
+    srand(3);
+    for (int i = 1; i < argc; i++) {
+        if (!read_wav(argv[i])) printf("[WARN] Não foi possível abrir %s\n", argv[i]);
+    }
+    if (janelas.empty()) {
+        printf("[INFO] Sem WAV: usando %d janelas sintéticas\n", SYNTH_WINDOWS);
+        synth_windows();
+    }
+
+    int falhas = 0;
+    size_t total = 0, saturados = 0, mudam_q15 = 0;
+    float erro_max = 0.0f;
+    std::vector<int8_t> ref(FEATURES), got(FEATURES), q15(FEATURES);
+    std::vector<float> features_q15(FEATURES);
+    matrix_t out(50, 13);
+
+    for (size_t w = 0; w < janelas.size(); w++) {
+        std::copy(janelas[w].begin(), janelas[w].end(), raw);
+        mfcc_window(&out);
+
+        quantize_loop(out.buffer, ref.data(), FEATURES);
+        simd::quantize_i8(out.buffer, got.data(), FEATURES, input_scale, input_zero_point);
+        for (size_t i = 0; i < FEATURES; i++) {
+            if (got[i] != ref[i] && falhas++ < 20) {
+                printf("[ERRO] janela %zu i=%zu: %d != %d (%.9g)\n", w, i, got[i], ref[i], out.buffer[i]);
+            }
+        }
+
+        for (size_t i = 0; i < FEATURES; i++) {
+            float x = out.buffer[i];
+            if (ref[i] == -128 || ref[i] == 127) {
+                saturados++;
+            } else {
+                erro_max = std::max(erro_max, fabsf((ref[i] - input_zero_point) * input_scale - x));
+            }
+            float q = roundf(x * Q11_ONE);
+            features_q15[i] = std::min(std::max(q, -32768.0f), 32767.0f) / Q11_ONE;
+        }
+        quantize_loop(features_q15.data(), q15.data(), FEATURES);
+        for (size_t i = 0; i < FEATURES; i++) mudam_q15 += (q15[i] != ref[i]);
+        total += FEATURES;
+    }
+
+    printf("[INFO] %zu janelas, %zu entradas do tensor\n", janelas.size(), total);
+    printf("  quantize_i8 vs laço original   %s\n", falhas ? "DIFERENTE" : "igual");
+    printf("  erro int8 vs float (máx)       %.4f (meio passo = %.4f)\n", erro_max, input_scale / 2);
+    printf("  entradas saturadas             %zu (%.2f%%)\n", saturados, 100.0 * saturados / total);
+    printf("  entradas que mudam com Q4.11   %zu (%.2f%%)\n", mudam_q15, 100.0 * mudam_q15 / total);
+
+    printf("[INFO] Por inferência (%s):\n", EIDSP_USE_NEON ? "NEON" : "escalar");
+    ei_memory_peak_use = ei_memory_in_use;
+    mfcc_window(&out);
+    printf("  pico de memória do DSP         %zu bytes\n", ei_memory_peak_use);
+    printf("  MFCC + CMVN                    %8.2f us\n", bench_us([&] { mfcc_window(&out); }));
+    printf("  laço pre_cast_quantize         %8.2f us\n", bench_us([&] { quantize_loop(out.buffer, ref.data(), FEATURES); }));
+    printf("  quantize_i8                    %8.2f us\n", bench_us([&] {
+        simd::quantize_i8(out.buffer, got.data(), FEATURES, input_scale, input_zero_point);
+    }));
+
+    if (falhas) {
+        printf("[ERRO] %d valores diferentes do laço original.\n", falhas);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+/*
+*   Medida de vazão do vosk_recognizer_accept_waveform* em um WAV gravado.
+*
+*   Decodifica o mesmo WAV com as três entradas (bytes, int16 e float), em blocos de 8000 amostras
+*   como o áudio do programa, e imprime o tempo de CPU por segundo de áudio e o fator de tempo real.
+*   O texto tem que sair igual nas três. Depois mede só a conversão int16 -> float de um bloco: o
+*   caminho anterior, copiado abaixo, que alocava um vetor novo e convertia amostra por amostra, e
+*   o atual, com buffer reaproveitado e NEON no aarch64. Para comparar a vazão completa com a
+*   versão anterior, rode o mesmo binário com a libvosk compilada antes da mudança.
+*
+*   No Pi:  cmake -DVOSK_TESTS=ON ... && make vosk_accept_waveform_bench
+*           && ./vosk_accept_waveform_bench <modelo> <wav>
+*
+*   @return 0 se as três entradas deram o mesmo texto.
+*/
+#include "vosk_api.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#define SAMPLE_RATE     16000
+#define CHUNK_SAMPLES   8000                                // Bloco do áudio do programa
+#define WAV_HEADER      44                                  // Cabeçalho PCM 16 bits mono
+#define RUNS            3                                   // Decodificações por entrada, vale a melhor
+#define CONVERT_RUNS    20000                               // Repetições da medida da conversão
+
+enum Entrada { BYTES, INT16, FLOAT };
+static const char* nomes[] = { "bytes", "int16", "float" };
+
+static bool read_wav(const char* path, std::vector<short>& samples) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, WAV_HEADER, SEEK_SET);
+    short buffer[CHUNK_SAMPLES];
+    size_t n;
+    while ((n = fread(buffer, sizeof(short), CHUNK_SAMPLES, f)) > 0) {
+        samples.insert(samples.end(), buffer, buffer + n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Decodifica o WAV inteiro e devolve o tempo bloqueado no Vosk em ms; o texto vai em texto
+static double decode(VoskModel* model, Entrada entrada, const std::vector<short>& samples,
+                     const std::vector<float>& samples_f, std::string& texto) {
+    VoskRecognizer* recognizer = vosk_recognizer_new(model, SAMPLE_RATE);
+    texto.clear();
+    std::chrono::steady_clock::duration bloqueado{0};
+    for (size_t pos = 0; pos < samples.size(); pos += CHUNK_SAMPLES) {
+        int len = static_cast<int>(std::min(static_cast<size_t>(CHUNK_SAMPLES), samples.size() - pos));
+        auto inicio = std::chrono::steady_clock::now();
+        int endpoint;
+        switch (entrada) {
+        case BYTES: endpoint = vosk_recognizer_accept_waveform(recognizer, reinterpret_cast<const char*>(&samples[pos]), len * 2); break;
+        case INT16: endpoint = vosk_recognizer_accept_waveform_s(recognizer, &samples[pos], len); break;
+        default:    endpoint = vosk_recognizer_accept_waveform_f(recognizer, &samples_f[pos], len); break;
+        }
+        bloqueado += std::chrono::steady_clock::now() - inicio;
+        if (endpoint) texto += vosk_recognizer_result(recognizer);
+    }
+    auto inicio = std::chrono::steady_clock::now();
+    texto += vosk_recognizer_final_result(recognizer);
+    bloqueado += std::chrono::steady_clock::now() - inicio;
+    vosk_recognizer_free(recognizer);
+    return std::chrono::duration<double, std::milli>(bloqueado).count();
+}
+
+// Conversão anterior: vetor novo a cada chamada, uma amostra por vez
+static float conversao_anterior(const short* in, int len) {
+    std::vector<float> wave(len);
+    for (int i = 0; i < len; i++) wave[i] = in[i];
+    return wave[len - 1];
+}
+
+// Conversão atual do Recognizer (ConvertSamples em recognizer.cc), em um buffer que só cresce
+static float conversao_atual(const short* in, int len, std::vector<float>& buffer) {
+    if (buffer.size() < static_cast<size_t>(len)) buffer.resize(len);
+    float* out = buffer.data();
+    int i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 8 <= len; i += 8) {
+        int16x8_t v = vld1q_s16(in + i);
+        vst1q_f32(out + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))));
+        vst1q_f32(out + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))));
+    }
+#endif
+    for (; i < len; i++) out[i] = in[i];
+    return out[len - 1];
+}
+
+template <typename F>
+static double bench_us(F f) {
+    volatile float sink = 0.0f;
+    auto inicio = std::chrono::steady_clock::now();
+    for (int i = 0; i < CONVERT_RUNS; i++) sink = sink + f();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - inicio).count() / CONVERT_RUNS;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("[ERRO] Uso: %s <modelo> <wav>\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<short> samples;
+    if (!read_wav(argv[2], samples) || samples.size() < CHUNK_SAMPLES) {
+        printf("[ERRO] Não foi possível ler %s\n", argv[2]);
+        return 1;
+    }
+    std::vector<float> samples_f(samples.begin(), samples.end());
+    double audio_s = samples.size() / static_cast<double>(SAMPLE_RATE);
+
+    vosk_set_log_level(-1);
+    VoskModel* model = vosk_model_new(argv[1]);
+    if (!model) {
+        printf("[ERRO] Não foi possível carregar o modelo %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("[INFO] %.1f s de áudio em blocos de %d amostras:\n", audio_s, CHUNK_SAMPLES);
+    std::string textos[3];
+    for (int entrada = BYTES; entrada <= FLOAT; entrada++) {
+        double melhor = 1e30;
+        for (int r = 0; r < RUNS; r++) {
+            melhor = std::min(melhor, decode(model, static_cast<Entrada>(entrada), samples, samples_f, textos[entrada]));
+        }
+        printf("  %-6s %8.1f ms, %6.2f ms por s de áudio, %6.1fx tempo real\n",
+               nomes[entrada], melhor, melhor / audio_s, audio_s * 1000.0 / melhor);
+    }
+    vosk_model_free(model);
+
+    std::vector<float> buffer;
+    printf("[INFO] Conversão int16 -> float de um bloco de %d amostras:\n", CHUNK_SAMPLES);
+    printf("  vetor novo, escalar    %8.2f us\n", bench_us([&] { return conversao_anterior(samples.data(), CHUNK_SAMPLES); }));
+    printf("  buffer reaproveitado   %8.2f us\n", bench_us([&] { return conversao_atual(samples.data(), CHUNK_SAMPLES, buffer); }));
+
+    if (textos[INT16] != textos[BYTES] || textos[FLOAT] != textos[BYTES]) {
+        printf("[ERRO] As entradas deram textos diferentes\n");
+        return 1;
+    }
+    printf("[INFO] Mesmo texto nas três entradas.\n");
+    return 0;
+}
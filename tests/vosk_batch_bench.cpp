@@ -0,0 +1,151 @@
+/*
+*   Medida de vazão do BatchRecognizer no backend de CPU (vosk_batch_*), contra o reconhecedor comum.
+*
+*   Decodifica um WAV como N fluxos simultâneos no VoskBatchModel, alimentados em rodízio em blocos
+*   de 8000 amostras como uma reprodução de missões gravadas, e mede o tempo de parede até o último
+*   resultado. Depois decodifica o mesmo WAV uma vez com o VoskRecognizer comum, que é o que se
+*   tinha sem CUDA, um fluxo por vez. Imprime os segundos de áudio por segundo de parede dos dois e
+*   quantos fluxos deram o mesmo texto do reconhecedor comum (os fluxos em lote são cortados nos
+*   endpoints em pedaços de ~10 s, então pequenas diferenças nas bordas são esperadas).
+*
+*   No Pi ou no servidor de testes:
+*           cmake -DVOSK_TESTS=ON ... && make vosk_batch_bench && ./vosk_batch_bench <modelo> <wav> [fluxos]
+*
+*   @return 0 se todos os fluxos em lote devolveram texto.
+*/
+#include "vosk_api.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#define SAMPLE_RATE     16000
+#define CHUNK_SAMPLES   8000                                // Bloco do áudio do programa
+#define WAV_HEADER      44                                  // Cabeçalho PCM 16 bits mono
+#define DEFAULT_STREAMS 8                                   // Fluxos simultâneos se não for informado
+
+static bool read_wav(const char* path, std::vector<short>& samples) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, WAV_HEADER, SEEK_SET);
+    short buffer[CHUNK_SAMPLES];
+    size_t n;
+    while ((n = fread(buffer, sizeof(short), CHUNK_SAMPLES, f)) > 0) {
+        samples.insert(samples.end(), buffer, buffer + n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Acrescenta o campo "text" de um resultado JSON, separado por espaço
+static void append_text(std::string& texto, const char* json) {
+    std::string s(json);
+    size_t chave = s.find("\"text\"");
+    if (chave == std::string::npos) return;
+    size_t inicio = s.find('"', s.find(':', chave) + 1);
+    size_t fim = s.find('"', inicio + 1);
+    if (inicio == std::string::npos || fim == std::string::npos || fim == inicio + 1) return;
+    if (!texto.empty()) texto += ' ';
+    texto += s.substr(inicio + 1, fim - inicio - 1);
+}
+
+static double segundos(std::chrono::steady_clock::time_point inicio) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+}
+
+// Todos os fluxos em lote; devolve o tempo de parede e o texto de cada fluxo
+static double decode_batch(const char* modelo, const std::vector<short>& samples, int fluxos,
+                           std::vector<std::string>& textos) {
+    VoskBatchModel* model = vosk_batch_model_new(modelo);
+    if (!model) return -1.0;
+    std::vector<VoskBatchRecognizer*> recognizers(fluxos);
+    for (int i = 0; i < fluxos; i++) recognizers[i] = vosk_batch_recognizer_new(model, SAMPLE_RATE);
+
+    auto inicio = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < samples.size(); pos += CHUNK_SAMPLES) {
+        int len = static_cast<int>(std::min(static_cast<size_t>(CHUNK_SAMPLES), samples.size() - pos));
+        for (int i = 0; i < fluxos; i++) {
+            vosk_batch_recognizer_accept_waveform(recognizers[i], reinterpret_cast<const char*>(&samples[pos]), len * 2);
+        }
+    }
+    for (int i = 0; i < fluxos; i++) vosk_batch_recognizer_finish_stream(recognizers[i]);
+    vosk_batch_model_wait(model);
+    double parede = segundos(inicio);
+
+    textos.assign(fluxos, std::string());
+    for (int i = 0; i < fluxos; i++) {
+        const char* r;
+        while (*(r = vosk_batch_recognizer_front_result(recognizers[i]))) {
+            append_text(textos[i], r);
+            vosk_batch_recognizer_pop(recognizers[i]);
+        }
+        vosk_batch_recognizer_free(recognizers[i]);
+    }
+    vosk_batch_model_free(model);
+    return parede;
+}
+
+// Um fluxo no reconhecedor comum
+static double decode_single(const char* modelo, const std::vector<short>& samples, std::string& texto) {
+    VoskModel* model = vosk_model_new(modelo);
+    if (!model) return -1.0;
+    VoskRecognizer* recognizer = vosk_recognizer_new(model, SAMPLE_RATE);
+
+    auto inicio = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < samples.size(); pos += CHUNK_SAMPLES) {
+        int len = static_cast<int>(std::min(static_cast<size_t>(CHUNK_SAMPLES), samples.size() - pos));
+        if (vosk_recognizer_accept_waveform_s(recognizer, &samples[pos], len)) {
+            append_text(texto, vosk_recognizer_result(recognizer));
+        }
+    }
+    append_text(texto, vosk_recognizer_final_result(recognizer));
+    double parede = segundos(inicio);
+
+    vosk_recognizer_free(recognizer);
+    vosk_model_free(model);
+    return parede;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("[ERRO] Uso: %s <modelo> <wav> [fluxos]\n", argv[0]);
+        return 1;
+    }
+    int fluxos = argc > 3 ? atoi(argv[3]) : DEFAULT_STREAMS;
+    std::vector<short> samples;
+    if (fluxos < 1 || !read_wav(argv[2], samples) || samples.empty()) {
+        printf("[ERRO] Não foi possível ler %s\n", argv[2]);
+        return 1;
+    }
+    double audio_s = samples.size() / static_cast<double>(SAMPLE_RATE);
+
+    vosk_set_log_level(-1);
+    std::string texto_single;
+    std::vector<std::string> textos;
+    double t_single = decode_single(argv[1], samples, texto_single);
+    double t_batch = decode_batch(argv[1], samples, fluxos, textos);
+    if (t_single < 0.0 || t_batch < 0.0) {
+        printf("[ERRO] Não foi possível carregar o modelo %s\n", argv[1]);
+        return 1;
+    }
+
+    int iguais = 0, vazios = 0;
+    for (const std::string& t : textos) {
+        iguais += (t == texto_single);
+        vazios += t.empty();
+    }
+    printf("[INFO] %.1f s de áudio, %d fluxos:\n", audio_s, fluxos);
+    printf("  reconhecedor comum   %8.2f s, %6.1f s de áudio por s\n", t_single, audio_s / t_single);
+    printf("  lote na CPU          %8.2f s, %6.1f s de áudio por s (%.1fx)\n", t_batch,
+           fluxos * audio_s / t_batch, (fluxos * audio_s / t_batch) / (audio_s / t_single));
+    printf("[INFO] %d de %d fluxos com o mesmo texto do reconhecedor comum\n", iguais, fluxos);
+
+    if (vazios) {
+        printf("[ERRO] %d fluxos sem texto\n", vazios);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+/*
+*   Medida de latência e acerto do early commit (vosk_recognizer_set_early_commit) em comandos gravados.
+*
+*   Cada gravação é decodificada duas vezes com a gramática de comandos.txt e os parâmetros do
+*   reconhecedor de main_full.cpp, em blocos de 100 ms: só com o endpointer e com o early commit.
+*   Para cada modo registra quanto áudio foi preciso para o resultado (o que atrasa o acionamento do
+*   motor/rabeta, independente da velocidade da CPU), o tempo de CPU gasto no Vosk e se a frase
+*   reconhecida é a esperada.
+*
+*   A lista de gravações tem uma por linha, no formato de comandos.txt (linhas vazias e # ignoradas):
+*       arquivo.wav;frase esperada
+*   com WAV PCM 16 bits mono a 16 kHz começando no comando (como o áudio após a wake word).
+*
+*   No Pi:  cmake -DVOSK_TESTS=ON -DVOSK_TEST_MODEL=<modelo> -DVOSK_TEST_CLIPS=<lista> ...
+*           && make vosk_early_commit_test && ./vosk_early_commit_test <modelo> comandos.txt <lista>
+*
+*   @return 0 se o early commit acertou todas as gravações que o endpointer acertou.
+*/
+#include "commands.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define SAMPLE_RATE     16000
+#define COMMAND_CHUNK   (SAMPLE_RATE / 10)                  // Bloco de 100 ms, como em main_full.cpp
+#define COMMAND_TIMEOUT (5 * SAMPLE_RATE)                   // Áudio máximo de um comando (5 s)
+#define EARLY_COMMIT_CONFIDENCE 0.9f                        // Mesmos valores de main_full.cpp
+#define EARLY_COMMIT_CHUNKS     2
+#define WAV_HEADER      44                                  // Cabeçalho PCM 16 bits mono
+#define MAX_WORDS       MAX_COMMAND_WORDS
+
+struct Gravacao {
+    std::string arquivo;
+    std::string frase;
+    std::vector<short> amostras;
+};
+
+struct Medida {
+    std::string texto;
+    size_t audio_ms;        // Áudio enviado até o resultado
+    double cpu_ms;          // Tempo bloqueado no Vosk
+};
+
+static bool read_wav(const std::string& path, std::vector<short>& samples) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    fseek(f, WAV_HEADER, SEEK_SET);
+    short buffer[COMMAND_CHUNK];
+    size_t n;
+    while ((n = fread(buffer, sizeof(short), COMMAND_CHUNK, f)) > 0) {
+        samples.insert(samples.end(), buffer, buffer + n);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool read_list(const char* path, std::vector<Gravacao>& gravacoes) {
+    std::ifstream lista(path);
+    if (!lista) return false;
+    std::string linha;
+    while (std::getline(lista, linha)) {
+        if (linha.empty() || linha[0] == '#') continue;
+        size_t sep = linha.find(';');
+        if (sep == std::string::npos) {
+            printf("[WARN] Linha ignorada: %s\n", linha.c_str());
+            continue;
+        }
+        Gravacao g;
+        g.arquivo = linha.substr(0, sep);
+        g.frase = linha.substr(sep + 1);
+        if (!read_wav(g.arquivo, g.amostras)) {
+            printf("[WARN] Não foi possível abrir %s\n", g.arquivo.c_str());
+            continue;
+        }
+        gravacoes.push_back(g);
+    }
+    return true;
+}
+
+static Medida decode(VoskRecognizer* recognizer, const std::vector<short>& samples) {
+    Medida m;
+    VoskWord words[MAX_WORDS];
+    VoskResult result;
+    result.words = words;
+    result.max_words = MAX_WORDS;
+
+    std::chrono::steady_clock::duration bloqueado{0};
+    size_t pos = 0, fim = std::min(samples.size(), static_cast<size_t>(COMMAND_TIMEOUT));
+    bool endpoint = false;
+    while (!endpoint && pos < fim) {
+        size_t len = std::min(static_cast<size_t>(COMMAND_CHUNK), fim - pos);
+        auto inicio = std::chrono::steady_clock::now();
+        endpoint = vosk_recognizer_accept_waveform_s(recognizer, &samples[pos], static_cast<int>(len));
+        bloqueado += std::chrono::steady_clock::now() - inicio;
+        pos += len;
+    }
+    auto inicio = std::chrono::steady_clock::now();
+    vosk_recognizer_get_result(recognizer, &result);
+    bloqueado += std::chrono::steady_clock::now() - inicio;
+
+    m.texto = result.text;
+    m.audio_ms = pos * 1000 / SAMPLE_RATE;
+    m.cpu_ms = std::chrono::duration<double, std::milli>(bloqueado).count();
+    vosk_recognizer_rearm(recognizer);
+    return m;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        printf("[ERRO] Uso: %s <modelo> <comandos.txt> <lista de gravações>\n", argv[0]);
+        return 1;
+    }
+
+    vosk_set_log_level(-1);
+    VoskModel* model = vosk_model_new(argv[1]);
+    if (!model) {
+        printf("[ERRO] Não foi possível carregar o modelo %s\n", argv[1]);
+        return 1;
+    }
+    CommandTable commands;
+    std::vector<Gravacao> gravacoes;
+    if (!commands.load(argv[2], model) || !read_list(argv[3], gravacoes) || gravacoes.empty()) {
+        printf("[ERRO] Sem comandos ou sem gravações\n");
+        vosk_model_free(model);
+        return 1;
+    }
+
+    VoskRecognizer* recognizers[2];
+    for (int modo = 0; modo < 2; modo++) {
+        recognizers[modo] = vosk_recognizer_new_grm(model, SAMPLE_RATE, commands.grammar().c_str());
+        vosk_recognizer_set_endpointer_delays(recognizers[modo], 3.0f, 0.3f, COMMAND_TIMEOUT / static_cast<float>(SAMPLE_RATE));
+        vosk_recognizer_set_early_commit(recognizers[modo], EARLY_COMMIT_CONFIDENCE, modo ? EARLY_COMMIT_CHUNKS : 0);
+        vosk_recognizer_set_closed_grammar(recognizers[modo], 1);
+        vosk_recognizer_set_always_on(recognizers[modo], 1);
+    }
+
+    int acertos[2] = { 0, 0 }, falhas = 0;
+    size_t audio_ms[2] = { 0, 0 };
+    double cpu_ms[2] = { 0.0, 0.0 };
+    for (const Gravacao& g : gravacoes) {
+        Medida m[2];
+        for (int modo = 0; modo < 2; modo++) {
+            m[modo] = decode(recognizers[modo], g.amostras);
+            acertos[modo] += (m[modo].texto == g.frase);
+            audio_ms[modo] += m[modo].audio_ms;
+            cpu_ms[modo] += m[modo].cpu_ms;
+        }
+        printf("  %-40s endpoint %5zu ms '%s', early commit %5zu ms '%s'\n", g.arquivo.c_str(),
+               m[0].audio_ms, m[0].texto.c_str(), m[1].audio_ms, m[1].texto.c_str());
+        if (m[0].texto == g.frase && m[1].texto != g.frase) {
+            printf("[ERRO] Early commit errou %s: esperado '%s'\n", g.arquivo.c_str(), g.frase.c_str());
+            falhas++;
+        }
+    }
+
+    size_t n = gravacoes.size();
+    printf("[INFO] %zu gravações\n", n);
+    printf("  endpoint      acertos %3d (%5.1f%%), áudio até o resultado %6zu ms, CPU %7.2f ms por comando\n",
+           acertos[0], 100.0 * acertos[0] / n, audio_ms[0] / n, cpu_ms[0] / n);
+    printf("  early commit  acertos %3d (%5.1f%%), áudio até o resultado %6zu ms, CPU %7.2f ms por comando\n",
+           acertos[1], 100.0 * acertos[1] / n, audio_ms[1] / n, cpu_ms[1] / n);
+
+    for (int modo = 0; modo < 2; modo++) vosk_recognizer_free(recognizers[modo]);
+    vosk_model_free(model);
+    return falhas ? 1 : 0;
+}
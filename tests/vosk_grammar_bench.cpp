@@ -0,0 +1,124 @@
+/*
+*   Medida do tempo de construção do grafo de gramática (LanguageModelEstimator + composição com HCLr).
+*
+*   Compila pela API (vosk_model_add_grammar_context) a gramática de comandos.txt e gramáticas de
+*   35, 500 e 5000 frases de 2 a 5 palavras sorteadas do vocabulário do modelo, com 40, 250 e 2500
+*   palavras distintas. O modelo guarda os grafos já compilados pelo texto da gramática, então cada
+*   repetição sorteia frases novas e o tempo é sempre de uma compilação completa; vale a melhor. Para
+*   comparar com o estimador anterior, rode o mesmo binário com a libvosk compilada antes da mudança.
+*
+*   No Pi:  cmake -DVOSK_TESTS=ON -DVOSK_TEST_MODEL=<modelo> ... && make vosk_grammar_bench
+*           && ./vosk_grammar_bench <modelo> comandos.txt
+*
+*   @return 0 se todas as gramáticas compilaram.
+*/
+#include "commands.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#define RUNS            5                                   // Compilações por tamanho, vale a melhor
+#define MIN_WORDS       2                                   // Palavras por frase sorteada
+#define MAX_WORDS       5
+
+struct Tamanho {
+    size_t frases;
+    size_t vocabulario;
+};
+
+static const Tamanho tamanhos[] = { { 35, 40 }, { 500, 250 }, { 5000, 2500 } };
+
+// Palavras de words.txt, sem <eps>, símbolos de desambiguação e marcas como [unk] e !SIL
+static bool read_words(const std::string& modelo, std::vector<std::string>& palavras) {
+    std::ifstream words(modelo + "/graph/words.txt");
+    if (!words) words.open(modelo + "/words.txt");
+    if (!words) return false;
+    std::string palavra, id;
+    while (words >> palavra >> id) {
+        if (palavra[0] == '<' || palavra[0] == '#' || palavra[0] == '[' || palavra[0] == '!') continue;
+        palavras.push_back(palavra);
+    }
+    return !palavras.empty();
+}
+
+static std::string sorteia_gramatica(const std::vector<std::string>& palavras, const Tamanho& t, std::mt19937& rng) {
+    std::vector<std::string> vocabulario;
+    std::sample(palavras.begin(), palavras.end(), std::back_inserter(vocabulario), t.vocabulario, rng);
+    std::string gramatica = "[";
+    for (size_t i = 0; i < t.frases; i++) {
+        size_t n = MIN_WORDS + rng() % (MAX_WORDS - MIN_WORDS + 1);
+        gramatica += i ? ", \"" : "\"";
+        for (size_t j = 0; j < n; j++) {
+            if (j) gramatica += ' ';
+            gramatica += vocabulario[rng() % vocabulario.size()];
+        }
+        gramatica += '"';
+    }
+    return gramatica + "]";
+}
+
+// Tempo de uma compilação em ms, negativo se falhou
+static double compila(VoskModel* model, const std::string& gramatica) {
+    auto inicio = std::chrono::steady_clock::now();
+    int ok = vosk_model_add_grammar_context(model, "bench", gramatica.c_str());
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count();
+    return ok ? ms : -1.0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("[ERRO] Uso: %s <modelo> <comandos.txt>\n", argv[0]);
+        return 1;
+    }
+
+    vosk_set_log_level(-1);
+    VoskModel* model = vosk_model_new(argv[1]);
+    if (!model) {
+        printf("[ERRO] Não foi possível carregar o modelo %s\n", argv[1]);
+        return 1;
+    }
+    CommandTable commands;
+    std::vector<std::string> palavras;
+    if (!commands.load(argv[2], model) || !read_words(argv[1], palavras)) {
+        printf("[ERRO] Sem comandos ou sem vocabulário no modelo\n");
+        vosk_model_free(model);
+        return 1;
+    }
+
+    int falhas = 0;
+    printf("[INFO] Construção do grafo de gramática (%zu palavras no vocabulário do modelo):\n", palavras.size());
+    double ms = compila(model, commands.grammar());
+    falhas += ms < 0.0;
+    printf("  comandos.txt                       %9.2f ms\n", ms);
+
+    std::mt19937 rng(3);
+    for (const Tamanho& t : tamanhos) {
+        if (t.vocabulario > palavras.size()) {
+            printf("[WARN] Vocabulário do modelo menor que %zu palavras, %zu frases ignoradas\n", t.vocabulario, t.frases);
+            continue;
+        }
+        double melhor = 1e30;
+        for (int r = 0; r < RUNS; r++) {
+            ms = compila(model, sorteia_gramatica(palavras, t, rng));
+            if (ms < 0.0) {
+                falhas++;
+                break;
+            }
+            melhor = std::min(melhor, ms);
+        }
+        printf("  %5zu frases, %4zu palavras         %9.2f ms\n", t.frases, t.vocabulario, melhor);
+    }
+
+    vosk_model_free(model);
+    if (falhas) {
+        printf("[ERRO] %d gramáticas não compilaram\n", falhas);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+*   Teste do modo worker_thread do reconhecedor Vosk (vosk_recognizer_set_worker_thread).
+*
+*   Decodifica o mesmo WAV duas vezes, em blocos de 100 ms: uma no modo síncrono e outra com a
+*   thread de decodificação. No modo worker, a cada endpoint continua enfileirando mais áudio antes
+*   de chamar vosk_recognizer_result(), para que a thread fique segurando blocos enquanto o
+*   CleanUp() recria o decoder. Os resultados de cada enunciado precisam ser iguais nos dois modos.
+*   Use um WAV com vários comandos separados por silêncio; rodar também com -fsanitize=thread.
+*
+*   No Pi:  cmake -DVOSK_TESTS=ON -DVOSK_TEST_MODEL=<modelo> -DVOSK_TEST_WAV=<wav> ...
+*           && make vosk_worker_test && ./vosk_worker_test <modelo> <wav>
+*
+*   @return 0 se os resultados dos dois modos forem iguais.
+*/
+#include "vosk_api.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#define SAMPLE_RATE     16000
+#define CHUNK_SAMPLES   1600                                // 100 ms a 16 kHz
+#define WAV_HEADER      44                                  // Cabeçalho PCM 16 bits mono
+#define HELD_CHUNKS     3                                   // Blocos enfileirados após o endpoint
+
+static bool read_wav(const char* path, std::vector<short>& samples) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, WAV_HEADER, SEEK_SET);
+    short buffer[CHUNK_SAMPLES];
+    size_t n;
+    while ((n = fread(buffer, sizeof(short), CHUNK_SAMPLES, f)) > 0) {
+        samples.insert(samples.end(), buffer, buffer + n);
+    }
+    fclose(f);
+    return true;
+}
+
+// Decodifica o áudio e devolve o texto de cada enunciado (um por endpoint, mais o final)
+static std::vector<std::string> decode(VoskModel* model, const std::vector<short>& samples, bool worker) {
+    std::vector<std::string> results;
+    VoskRecognizer* recognizer = vosk_recognizer_new(model, SAMPLE_RATE);
+    vosk_recognizer_set_worker_thread(recognizer, worker ? 1 : 0);
+
+    size_t pos = 0;
+    while (pos < samples.size()) {
+        size_t len = std::min(static_cast<size_t>(CHUNK_SAMPLES), samples.size() - pos);
+        bool endpoint = vosk_recognizer_accept_waveform_s(recognizer, &samples[pos], static_cast<int>(len));
+        pos += len;
+        if (!endpoint) continue;
+
+        if (worker) {
+            // A thread segura estes blocos até o próximo enunciado começar
+            for (int i = 0; i < HELD_CHUNKS && pos < samples.size(); i++) {
+                len = std::min(static_cast<size_t>(CHUNK_SAMPLES), samples.size() - pos);
+                vosk_recognizer_accept_waveform_s(recognizer, &samples[pos], static_cast<int>(len));
+                pos += len;
+            }
+        }
+        results.push_back(vosk_recognizer_result(recognizer));
+    }
+    results.push_back(vosk_recognizer_final_result(recognizer));
+    vosk_recognizer_free(recognizer);
+    return results;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("[ERRO] Uso: %s <modelo> <wav 16 kHz mono>\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<short> samples;
+    if (!read_wav(argv[2], samples)) {
+        printf("[ERRO] Não foi possível abrir %s\n", argv[2]);
+        return 1;
+    }
+
+    vosk_set_log_level(-1);
+    VoskModel* model = vosk_model_new(argv[1]);
+    if (!model) {
+        printf("[ERRO] Não foi possível carregar o modelo %s\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<std::string> sync_results = decode(model, samples, false);
+    std::vector<std::string> worker_results = decode(model, samples, true);
+    vosk_model_free(model);
+
+    int falhas = 0;
+    if (sync_results.size() != worker_results.size()) {
+        printf("[ERRO] %zu enunciados no modo síncrono, %zu no modo worker\n",
+               sync_results.size(), worker_results.size());
+        falhas++;
+    }
+    for (size_t i = 0; i < sync_results.size() && i < worker_results.size(); i++) {
+        if (sync_results[i] != worker_results[i]) {
+            printf("[ERRO] Enunciado %zu difere:\n  síncrono: %s\n  worker:   %s\n",
+                   i, sync_results[i].c_str(), worker_results[i].c_str());
+            falhas++;
+        }
+    }
+
+    if (falhas) {
+        printf("[ERRO] %d falha(s)\n", falhas);
+        return 1;
+    }
+    printf("[INFO] %zu enunciados iguais nos dois modos\n", sync_results.size());
+    return 0;
+}
@@ -19,9 +19,10 @@
 #include "spk_model.h"
 #include "postprocessor.h"
 
+#include "batch_recognizer.h"
+
 #if HAVE_CUDA
 #include "cudamatrix/cu-device.h"
-#include "batch_recognizer.h"
 #endif
 
 #include <string.h>
@@ -50,6 +51,15 @@ int vosk_model_find_word(VoskModel *model, const char *word)
     return (int) ((Model *)model)->FindWord(word);
 }
 
+int vosk_model_add_grammar_context(VoskModel *model, const char *name, const char *grammar)
+{
+    try {
+        return ((Model *)model)->AddGrammarContext(name, grammar);
+    } catch (...) {
+        return 0;
+    }
+}
+
 VoskSpkModel *vosk_spk_model_new(const char *model_path)
 {
     try {
@@ -130,6 +140,18 @@ void vosk_recognizer_set_grm(VoskRecognizer *recognizer, char const *grammar)
     ((Recognizer *)recognizer)->SetGrm(grammar);
 }
 
+int vosk_recognizer_set_grammar_context(VoskRecognizer *recognizer, const char *name)
+{
+    if (recognizer == nullptr) {
+       return 0;
+    }
+    try {
+        return ((Recognizer *)recognizer)->SetGrammarContext(name);
+    } catch (...) {
+        return 0;
+    }
+}
+
 void vosk_recognizer_set_endpointer_mode(VoskRecognizer *recognizer, VoskEndpointerMode mode)
 {
     if (recognizer == nullptr) {
@@ -146,6 +168,38 @@ void vosk_recognizer_set_endpointer_delays(VoskRecognizer *recognizer, float t_s
     ((Recognizer *)recognizer)->SetEndpointerDelays(t_start_max, t_end, t_max);
 }
 
+void vosk_recognizer_set_early_commit(VoskRecognizer *recognizer, float min_confidence, int stable_chunks)
+{
+    if (recognizer == nullptr) {
+       return;
+    }
+    ((Recognizer *)recognizer)->SetEarlyCommit(min_confidence, stable_chunks);
+}
+
+void vosk_recognizer_set_closed_grammar(VoskRecognizer *recognizer, int closed_grammar)
+{
+    if (recognizer == nullptr) {
+       return;
+    }
+    ((Recognizer *)recognizer)->SetClosedGrammar((bool)closed_grammar);
+}
+
+void vosk_recognizer_set_always_on(VoskRecognizer *recognizer, int always_on)
+{
+    if (recognizer == nullptr) {
+       return;
+    }
+    ((Recognizer *)recognizer)->SetAlwaysOn((bool)always_on);
+}
+
+void vosk_recognizer_set_worker_thread(VoskRecognizer *recognizer, int worker_thread)
+{
+    if (recognizer == nullptr) {
+       return;
+    }
+    ((Recognizer *)recognizer)->SetWorkerThread((bool)worker_thread);
+}
+
 int vosk_recognizer_accept_waveform(VoskRecognizer *recognizer, const char *data, int length)
 {
     try {
@@ -178,6 +232,27 @@ const char *vosk_recognizer_result(VoskRecognizer *recognizer)
     return ((Recognizer *)recognizer)->Result();
 }
 
+int vosk_recognizer_get_result(VoskRecognizer *recognizer, VoskResult *result)
+{
+    try {
+        const RecognizerResult &res = ((Recognizer *)recognizer)->StructuredResult();
+        result->text = res.text.c_str();
+        result->num_words = res.words.size();
+        for (int i = 0; i < result->num_words && i < result->max_words; i++) {
+            const RecognizerWord &w = res.words[i];
+            result->words[i].id = w.id;
+            result->words[i].text_start = w.text_start;
+            result->words[i].text_length = w.text_length;
+            result->words[i].conf = w.conf;
+            result->words[i].start = w.start;
+            result->words[i].end = w.end;
+        }
+        return result->num_words;
+    } catch (...) {
+        return -1;
+    }
+}
+
 const char *vosk_recognizer_partial_result(VoskRecognizer *recognizer)
 {
     return ((Recognizer *)recognizer)->PartialResult();
@@ -193,6 +268,11 @@ void vosk_recognizer_reset(VoskRecognizer *recognizer)
     ((Recognizer *)recognizer)->Reset();
 }
 
+void vosk_recognizer_rearm(VoskRecognizer *recognizer)
+{
+    ((Recognizer *)recognizer)->Rearm();
+}
+
 void vosk_recognizer_free(VoskRecognizer *recognizer)
 {
     delete (Recognizer *)(recognizer);
@@ -222,88 +302,62 @@ void vosk_gpu_thread_init()
 
 VoskBatchModel *vosk_batch_model_new(const char *model_path)
 {
-#if HAVE_CUDA
-    return (VoskBatchModel *)(new BatchModel(model_path));
-#else
-    return NULL;
-#endif
+    try {
+        return (VoskBatchModel *)(new BatchModel(model_path));
+    } catch (...) {
+        return nullptr;
+    }
 }
 
 void vosk_batch_model_free(VoskBatchModel *model)
 {
-#if HAVE_CUDA
     delete ((BatchModel *)model);
-#endif
 }
 
 void vosk_batch_model_wait(VoskBatchModel *model)
 {
-#if HAVE_CUDA
     ((BatchModel *)model)->WaitForCompletion();
-#endif
 }
 
 VoskBatchRecognizer *vosk_batch_recognizer_new(VoskBatchModel *model, float sample_rate)
 {
-#if HAVE_CUDA
     return (VoskBatchRecognizer *)(new BatchRecognizer((BatchModel *)model, sample_rate));
-#else
-    return NULL;
-#endif
 }
 
 void vosk_batch_recognizer_free(VoskBatchRecognizer *recognizer)
 {
-#if HAVE_CUDA
     delete ((BatchRecognizer *)recognizer);
-#endif
 }
 
 void vosk_batch_recognizer_accept_waveform(VoskBatchRecognizer *recognizer, const char *data, int length)
 {
-#if HAVE_CUDA
     ((BatchRecognizer *)recognizer)->AcceptWaveform(data, length);
-#endif
 }
 
 void vosk_batch_recognizer_set_nlsml(VoskBatchRecognizer *recognizer, int nlsml)
 {
-#if HAVE_CUDA
     ((BatchRecognizer *)recognizer)->SetNLSML((bool)nlsml);
-#endif
 }
 
 void vosk_batch_recognizer_finish_stream(VoskBatchRecognizer *recognizer)
 {
-#if HAVE_CUDA
     ((BatchRecognizer *)recognizer)->FinishStream();
-#endif
 }
 
 const char *vosk_batch_recognizer_front_result(VoskBatchRecognizer *recognizer)
 {
-#if HAVE_CUDA
     return ((BatchRecognizer *)recognizer)->FrontResult();
-#else
-    return NULL;
-#endif
 }
 
 void vosk_batch_recognizer_pop(VoskBatchRecognizer *recognizer)
 {
-#if HAVE_CUDA
     ((BatchRecognizer *)recognizer)->Pop();
-#endif
 }
 
 
 int vosk_batch_recognizer_get_pending_chunks(VoskBatchRecognizer *recognizer)
 {
-#if HAVE_CUDA
     return ((BatchRecognizer *)recognizer)->GetNumPendingChunks();
-#else
-    return 0;
-#endif
 }
 
 VoskTextProcessor *vosk_text_processor_new(const char *tagger, const char *verbalizer)
@@ -52,6 +52,24 @@ typedef struct VoskBatchModel VoskBatchModel;
  */
 typedef struct VoskBatchRecognizer VoskBatchRecognizer;
 
+/** Word of a structured result, see vosk_recognizer_get_result() */
+typedef struct VoskWord {
+    int id;             /**< word id in the model, same as vosk_model_find_word() */
+    int text_start;     /**< offset of the word in VoskResult.text */
+    int text_length;    /**< length of the word in VoskResult.text */
+    float conf;         /**< confidence, 0.0 - 1.0, in the closed grammar profile the posterior of the whole one-best path */
+    float start;        /**< start time in seconds */
+    float end;          /**< end time in seconds */
+} VoskWord;
+
+/** Structured result, filled by vosk_recognizer_get_result() */
+typedef struct VoskResult {
+    const char *text;   /**< decoded words separated by spaces, owned by the recognizer */
+    int num_words;      /**< number of words in the result, can be larger than max_words */
+    int max_words;      /**< capacity of words, set by the caller */
+    VoskWord *words;    /**< array provided by the caller, can be NULL if max_words is 0 */
+} VoskResult;
+
 
 /** Loads model data from the file and returns the model object
  *
@@ -76,6 +94,20 @@ void vosk_model_free(VoskModel *model);
 int vosk_model_find_word(VoskModel *model, const char *word);
 
 
+/** Registers a named grammar context
+ *
+ * The grammar is compiled once and kept in the model, so recognizers of this
+ * model can switch to it with vosk_recognizer_set_grammar_context() without
+ * being recreated. Registering a name again replaces the grammar.
+ *
+ * Only lookahead models support runtime grammars.
+ *
+ * @param name     context name, e.g. "confirm"
+ * @param grammar  set of phrases in JSON array of strings, see vosk_recognizer_new_grm
+ * @returns 1 on success, 0 if the grammar is invalid or not supported by the model */
+int vosk_model_add_grammar_context(VoskModel *model, const char *name, const char *grammar);
+
+
 /** Loads speaker model data from the file and returns the model object
  *
  * @param model_path: the path of the model on the filesystem
@@ -127,6 +159,10 @@ VoskRecognizer *vosk_recognizer_new_spk(VoskModel *model, float sample_rate, Vos
  *  Only recognizers with lookahead models support this type of quick configuration.
  *  Precompiled HCLG graph models are not supported.
  *
+ *  The decoding graph for a grammar is compiled on first use and cached in the model,
+ *  so later recognizers with the same grammar string share it and are cheap to create.
+ *  For a fixed command list, see vosk_recognizer_set_closed_grammar().
+ *
  *  @param model       VoskModel containing static data for recognizer. Model can be
  *                     shared across recognizers, even running in different threads.
  *  @param sample_rate The sample rate of the audio you going to feed into the recognizer.
@@ -157,6 +193,18 @@ void vosk_recognizer_set_spk_model(VoskRecognizer *recognizer, VoskSpkModel *spk
 void vosk_recognizer_set_grm(VoskRecognizer *recognizer, char const *grammar);
 
 
+/** Switches the recognizer to a grammar context registered in the model
+ *
+ * Unlike vosk_recognizer_set_grm, this can be called while the recognizer is
+ * running. The current utterance finishes with the old grammar, the new one
+ * is active from the next utterance on. Only the decoder is replaced, the
+ * feature pipeline and the i-vector state are kept, and no graph is compiled.
+ *
+ * @param name  context name given to vosk_model_add_grammar_context
+ * @returns 1 on success, 0 if there is no context with this name */
+int vosk_recognizer_set_grammar_context(VoskRecognizer *recognizer, const char *name);
+
+
 /** Configures recognizer to output n-best results
  *
  * <pre>
@@ -242,6 +290,78 @@ void vosk_recognizer_set_endpointer_mode(VoskRecognizer *recognizer,  VoskEndpoi
  **/
 void vosk_recognizer_set_endpointer_delays(VoskRecognizer *recognizer, float t_start_max, float t_end, float t_max);
 
+/**
+ * Enables early commit for grammar recognizers
+ *
+ * With a closed grammar the utterance is often complete before the trailing silence.
+ * When the best partial hypothesis is a whole grammar phrase, every word has at least
+ * min_confidence and the hypothesis stays the same for stable_chunks accepted chunks,
+ * vosk_recognizer_accept_waveform returns 1 as for an endpoint and the phrase can be
+ * read with vosk_recognizer_result. A phrase that starts a longer grammar phrase
+ * ("velocidade vinte" and "velocidade vinte e cinco") is never committed early, it
+ * waits for the endpoint. The count advances once per accepted chunk, so feed each
+ * chunk in a single call.
+ *
+ * @param min_confidence  minimum word confidence in the partial lattice (0.0 - 1.0)
+ * @param stable_chunks   number of consecutive chunks with the same phrase, 0 disables early commit
+ **/
+void vosk_recognizer_set_early_commit(VoskRecognizer *recognizer, float min_confidence, int stable_chunks);
+
+/**
+ * Switches the closed grammar profile on or off
+ *
+ * With a closed grammar, rescoring with the large vocabulary language model of the
+ * model directory only costs time and memory. In this profile the recognizer doesn't
+ * load or build the rescoring models, and unless word times are requested with
+ * vosk_recognizer_set_words() the result is the one-best path of the lattice, without
+ * word alignment and MBR. The confidence of each word in such results is the
+ * posterior of the whole one-best path, never above the posterior of the word itself.
+ *
+ * Disabled by default. Enable it right after creating the recognizer: the rescoring
+ * models are only loaded for the first result, so they are then never loaded.
+ *
+ * @param closed_grammar - boolean value
+ **/
+void vosk_recognizer_set_closed_grammar(VoskRecognizer *recognizer, int closed_grammar);
+
+/**
+ * Switches the always-on mode on or off
+ *
+ * By default the recognizer drops its feature pipeline and decoder every ten
+ * minutes of audio to bound memory, which costs a latency spike and resets the
+ * i-vector adaptation. In always-on mode the pipeline recycles its oldest
+ * feature frames, and is rebuilt only every 30 minutes of audio, at the start of
+ * an utterance, with the i-vector adaptation state carried over. The rebuild is
+ * what bounds the i-vector history and the cached CMVN stats, which grow with
+ * every frame (a few MB per 10 minutes). So a recognizer fed continuously for
+ * hours keeps its adaptation, with one latency spike per 30 minutes.
+ *
+ * vosk_recognizer_final_result() still rebuilds the pipeline, since it closes
+ * the input. Use vosk_recognizer_result() or vosk_recognizer_rearm() between
+ * utterances instead.
+ *
+ * @param always_on - boolean value
+ */
+void vosk_recognizer_set_always_on(VoskRecognizer *recognizer, int always_on);
+
+/**
+ * Moves decoding to a dedicated worker thread
+ *
+ * By default feature extraction, the acoustic model and the search run inside
+ * vosk_recognizer_accept_waveform() on the calling thread. With a worker thread
+ * the call only queues a copy of the audio and returns, so the calling thread
+ * (e.g. audio capture) is never held up by decoding. The endpoint it returns is
+ * the one found in the audio decoded so far, which may be a chunk behind. The
+ * worker stops decoding at the endpoint, so the result only covers audio up to
+ * it. Audio queued after the endpoint is held and starts the next utterance,
+ * once vosk_recognizer_result() or vosk_recognizer_final_result() has ended the
+ * current one. vosk_recognizer_rearm() and switching the worker thread off drop it.
+ * The result and configuration calls wait for the queued audio to be decoded first.
+ *
+ * @param worker_thread - boolean value
+ */
+void vosk_recognizer_set_worker_thread(VoskRecognizer *recognizer, int worker_thread);
+
 /** Accept voice data
  *
  *  accept and process new chunk of voice data
@@ -283,6 +403,19 @@ int vosk_recognizer_accept_waveform_f(VoskRecognizer *recognizer, const float *d
 const char *vosk_recognizer_result(VoskRecognizer *recognizer);
 
 
+/** Returns speech recognition result without JSON
+ *
+ *  Same as vosk_recognizer_result() for a recognizer without alternatives, but the
+ *  one-best words are written into a caller-provided struct and no JSON is produced.
+ *  Use one or the other for an utterance, not both.
+ *
+ *  @param result      struct with max_words and words set by the caller. text stays
+ *                     valid until the next call on the recognizer.
+ *  @returns number of words in the result, or -1 on error
+ */
+int vosk_recognizer_get_result(VoskRecognizer *recognizer, VoskResult *result);
+
+
 /** Returns partial speech recognition
  *
  * @returns partial speech recognition text which is not yet finalized.
@@ -312,6 +445,16 @@ const char *vosk_recognizer_final_result(VoskRecognizer *recognizer);
 void vosk_recognizer_reset(VoskRecognizer *recognizer);
 
 
+/** Rearms the recognizer for a new utterance
+ *
+ *  Drops the current utterance without decoding it to the end, so the next
+ *  accepted waveform starts a new one. Unlike freeing and creating a new
+ *  recognizer, the decoder, feature pipeline and graph are kept and reused.
+ *  Audio is expected to continue from where it was left, a gap in the stream
+ *  only affects the first few frames. */
+void vosk_recognizer_rearm(VoskRecognizer *recognizer);
+
+
 /** Releases recognizer object
  *
  *  Underlying model is also unreferenced and if needed released */
@@ -341,6 +484,12 @@ void vosk_gpu_init();
 void vosk_gpu_thread_init();
 
 /** Creates the batch recognizer object
+ *
+ *  With HAVE_CUDA the streams are decoded on the GPU as they arrive. Without it
+ *  a CPU backend is used: the audio of each stream is decoded in pieces of a few
+ *  seconds, one stream per core in parallel, with the nnet computation of
+ *  concurrent streams done in shared minibatches. Both backends split streams
+ *  on endpoints and return one result per utterance.
  *
  *  @returns model object or NULL if problem occured */
 VoskBatchModel *vosk_batch_model_new(const char *model_path);